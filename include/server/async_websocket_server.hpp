@@ -1,30 +1,72 @@
 #pragma once
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "io_context_pool.hpp"
 #include "websocket_server_common.hpp"
 
 class AsyncSocketAcceptor;
+class AsyncWebSocketConnection;
+
+// Live connections of one server, including the ones that have not identified themselves yet.
+// Connections deregister from their destructor, i.e. once every pending handler has released them.
+class AsyncConnectionRegistry
+{
+  public:
+	void add(const std::shared_ptr<AsyncWebSocketConnection>& connection);
+	void remove(const AsyncWebSocketConnection* connection);
+
+	[[nodiscard]] std::vector<std::shared_ptr<AsyncWebSocketConnection>> snapshot() const;
+	[[nodiscard]] std::size_t size() const;
+	void on_empty(std::function<void()> callback); // Runs immediately if there is no connection left
+
+  private:
+	mutable std::mutex mutex_;
+	std::unordered_map<const AsyncWebSocketConnection*, std::weak_ptr<AsyncWebSocketConnection>> connections_;
+	std::vector<std::function<void()>> empty_callbacks_;
+};
 
 class AsyncWebSocketServer final : public WebSocketServer, public std::enable_shared_from_this<AsyncWebSocketServer>
 {
   public:
-	explicit AsyncWebSocketServer(boost::asio::io_context& io_context);
+	AsyncWebSocketServer(boost::asio::io_context& io_context, IoContextPool& io_context_pool);
 
 	void start() override;
-	void stop() override;
+	void stop() override; // Blocking wrapper around async_stop(), must not be called from an io thread
+
+	// Closes every connection concurrently. Connections still open after grace_period are force-closed.
+	// The future (and on_stopped) completes once the last connection is gone.
+	std::future<void> async_stop(std::chrono::milliseconds grace_period, std::function<void()> on_stopped = {});
 
   private:
+	void schedule_session_manage();
+
+	std::shared_ptr<AsyncConnectionRegistry> connection_registry_;
+	std::shared_ptr<BufferPool> buffer_pool_; // Receive buffers of this server's connections
 	std::shared_ptr<AsyncSocketAcceptor> socket_acceptor_;
+	boost::asio::steady_timer session_log_timer_; // Drives on_session_manage() on the acceptor's io_context
 	friend class AsyncWebSocketConnection;
 };
 
 class AsyncSocketAcceptor
 {
   public:
-	explicit AsyncSocketAcceptor(boost::asio::io_context& io_context);
+	AsyncSocketAcceptor(boost::asio::io_context& io_context, IoContextPool& io_context_pool,
+	                    const std::shared_ptr<AsyncConnectionRegistry>& connection_registry,
+	                    const std::shared_ptr<BufferPool>& buffer_pool);
 
 	void do_accept();
 
   private:
+	[[nodiscard]] bool at_capacity() const; // Admitted plus pending connections reached their limit
+
 	boost::asio::io_context& io_context_;
+	IoContextPool& io_context_pool_; // Accepted sockets are bound to the next io_context of the pool
+	std::shared_ptr<AsyncConnectionRegistry> connection_registry_;
+	std::shared_ptr<BufferPool> buffer_pool_;
 	std::shared_ptr<boost::asio::ip::tcp::acceptor> acceptor_;
 	friend class AsyncWebSocketServer;
 };
@@ -33,11 +75,33 @@ class AsyncWebSocketConnection final : public WebSocketConnection,
                                        public std::enable_shared_from_this<AsyncWebSocketConnection>
 {
   public:
-	explicit AsyncWebSocketConnection(const std::shared_ptr<Socket>& socket);
+	AsyncWebSocketConnection(const std::shared_ptr<Socket>& socket,
+	                         const std::shared_ptr<AsyncConnectionRegistry>& connection_registry,
+	                         const std::shared_ptr<BufferPool>& buffer_pool);
+	~AsyncWebSocketConnection() override;
 
-	void upgrade() override;
+	void upgrade() override; // Reads the HTTP upgrade request, asks on_session_admit(), then accepts or rejects
 	void do_read() override;
 
+	void close();       // WebSocket close handshake, posted to the connection's io_context
+	void force_close(); // Closes the socket, aborting every pending operation
+
   private:
+	void accept_websocket();
+	void arm_idle_timer();
+	void on_idle_timer();
+	void on_closed();
+
+	const std::string device_ip_; // Resolved once, the socket may already be gone when a handler fails
+	const std::string device_id_; // Session map key, unique per connection
+	std::shared_ptr<WebSocketServerContext::Session> session_; // Cached once the device has identified itself
+	std::shared_ptr<WebSocketServerContext::Buffer> read_buffer_; // Reused while no consumer holds on to it
+	boost::asio::steady_timer idle_timer_;                        // Expires the connection after session_timeout
+	WebSocketServerContext::TimePoint last_received_;             // Only touched on the connection's io thread
+	std::shared_ptr<AsyncConnectionRegistry> connection_registry_;
+	std::shared_ptr<BufferPool> buffer_pool_; // Pool of the server that accepted it, outlives a restart
+	WebSocketServerContext::UpgradeRequest upgrade_request_; // Released once the upgrade has completed
+	boost::beast::flat_buffer upgrade_buffer_;
+	WebSocketServerContext::AdmissionTicket admission_;
 	friend class AsyncWebSocketServer;
 };
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Bounded pool of receive buffers.
+// acquire() hands out a shared_ptr whose deleter returns the buffer (with its grown capacity) to the pool,
+// so a consumer can keep a frame alive while the connection already reads the next one into another buffer.
+class BufferPool final : public std::enable_shared_from_this<BufferPool>
+{
+  public:
+	using Buffer = boost::beast::flat_buffer;
+
+	struct Stats
+	{
+		std::uint64_t hits      = 0; // acquire() served from the pool
+		std::uint64_t misses    = 0; // acquire() had to allocate a new buffer
+		std::uint64_t discarded = 0; // Returned buffers dropped because the pool was full or they grew too large
+		std::size_t pooled      = 0; // Buffers currently waiting in the pool
+	};
+
+	BufferPool(std::size_t capacity, std::size_t max_buffer_bytes);
+
+	std::shared_ptr<Buffer> acquire();
+	[[nodiscard]] Stats stats() const;
+
+  private:
+	void recycle(Buffer* buffer);
+
+	const std::size_t capacity_;
+	const std::size_t max_buffer_bytes_;
+
+	mutable std::mutex mutex_;
+	std::vector<std::unique_ptr<Buffer>> free_buffers_;
+
+	std::atomic<std::uint64_t> hits_      = 0;
+	std::atomic<std::uint64_t> misses_    = 0;
+	std::atomic<std::uint64_t> discarded_ = 0;
+};
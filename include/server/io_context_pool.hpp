@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Pool of io_contexts, each run by exactly one thread.
+// Connections are handed out round-robin, so every handler of a connection runs on the same thread
+// (an implicit strand) while different connections are spread across cores.
+class IoContextPool
+{
+  public:
+	explicit IoContextPool(std::size_t pool_size);
+	~IoContextPool();
+
+	IoContextPool(const IoContextPool&)            = delete;
+	IoContextPool& operator=(const IoContextPool&) = delete;
+
+	void run();
+	void stop();
+
+	boost::asio::io_context& get_io_context(); // Next io_context in round-robin order
+	[[nodiscard]] std::size_t size() const;
+
+  private:
+	using WorkGuard = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+	std::vector<std::unique_ptr<boost::asio::io_context>> io_contexts_;
+	std::vector<WorkGuard> work_guards_;
+	std::vector<std::thread> threads_;
+	std::atomic_size_t next_io_context_ = 0;
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <memory>
+
+// Local HTTP endpoint answering GET /metrics with Metrics::registry().render() (Prometheus text format).
+// Runs on the given io_context and serves one short-lived request per connection.
+class MetricsServer final : public std::enable_shared_from_this<MetricsServer>
+{
+  public:
+	MetricsServer(boost::asio::io_context& io_context, unsigned short port);
+
+	void start();
+	void stop();
+
+  private:
+	void do_accept();
+
+	boost::asio::ip::tcp::acceptor acceptor_;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/websocket.hpp>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+// Per-connection outbound message queue.
+// send() may be called from any thread; the queue itself is only touched on the WebSocket's executor, which
+// serializes async_write calls without blocking the connection's read loop. Messages carrying a coalesce key
+// replace a still-queued message with the same key (e.g. a newer "set_fps" supersedes an older one), and the
+// total number of queued bytes is bounded.
+// Coalescing here means superseding only: every message that is sent stays its own WebSocket message, small
+// messages are not concatenated into one write, since devices parse one JSON object per message.
+class OutboundQueue final : public std::enable_shared_from_this<OutboundQueue>
+{
+  public:
+	using WebSocket = boost::beast::websocket::stream<boost::asio::ip::tcp::socket>;
+
+	OutboundQueue(const std::shared_ptr<WebSocket>& ws, std::size_t max_queued_bytes);
+
+	// Returns false if the message was rejected because the byte budget is exhausted
+	bool send(std::string payload, bool text = true, std::string coalesce_key = {});
+
+	[[nodiscard]] std::size_t queued_bytes() const;
+	[[nodiscard]] std::uint64_t rejected() const;
+
+  private:
+	struct Message
+	{
+		std::string payload;
+		bool text;
+		std::string coalesce_key;
+	};
+
+	void enqueue(Message message); // Executor only
+	void do_write();               // Executor only
+
+	const std::shared_ptr<WebSocket> ws_;
+	const std::size_t max_queued_bytes_;
+
+	std::atomic<std::size_t> queued_bytes_ = 0; // Reserved in send(), so the bound holds across threads
+	std::atomic<std::uint64_t> rejected_   = 0;
+
+	std::deque<Message> queue_; // Front is the message being written while writing_ is set
+	bool writing_ = false;
+};
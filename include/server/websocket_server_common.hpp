@@ -2,11 +2,15 @@
 #include <boost/asio.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/beast/core/buffers_to_string.hpp>
+#include <boost/beast/http.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/unordered/concurrent_flat_map.hpp>
 #include <fmt/core.h>
 #include <memory>
 
+#include "buffer_pool.hpp"
+#include "outbound_queue.hpp"
+
 using Socket = boost::asio::ip::tcp::socket;
 
 namespace WebSocketServerContext
@@ -22,13 +26,26 @@ using Buffer     = boost::beast::flat_buffer;
 using WebSocket  = boost::beast::websocket::stream<Socket>;
 using SessionMap = boost::concurrent_flat_map<std::string, std::shared_ptr<Session>>;
 
+using UpgradeRequest  = boost::beast::http::request<boost::beast::http::empty_body>;
+using AdmissionTicket = std::shared_ptr<void>; // Held by a connection for its lifetime, releasing it frees the slot
+
 // Server configuration structure
 struct ServerConfig
 {
-	int server_port              = 3000;
-	int max_session              = 5;
-	int session_timeout          = 10;
-	int session_manage_period_ms = 50;
+	int server_port             = 3000;
+	int max_session             = 5;               // Admitted connections across all device types
+	int max_camera_session      = 0;               // 0: cameras are only bounded by max_session
+	int max_wearable_session    = 0;               // 0: wearables are only bounded by max_session
+	int max_pending_connection  = 4;               // Extra connections allowed to queue for admission
+	int admission_retry_after   = 5;               // Seconds, Retry-After of the 503 sent to rejected connections
+	int session_timeout         = 10;              // Seconds without data before a connection is closed
+	int session_log_period      = 10;              // Seconds between on_session_manage() calls
+	int io_context_pool_size    = 0;               // 0: one io_context per hardware thread
+	int buffer_pool_size        = 32;              // Receive buffers kept for reuse across all connections
+	int max_pooled_buffer_bytes = 4 * 1024 * 1024; // Larger buffers are freed instead of pooled
+	int shutdown_grace_period   = 1000;            // Milliseconds to wait for close handshakes on stop
+	int max_outbound_bytes      = 256 * 1024;      // Bytes a connection may have queued for sending
+	int metrics_port            = 9100;            // Local HTTP /metrics endpoint, 0 disables it
 };
 
 // Session structure holding WebSocket and session info
@@ -36,22 +53,30 @@ struct Session
 {
 	std::shared_ptr<WebSocket> ws;
 	std::shared_ptr<SessionInfo> info;
+	std::string device_ip;
+	std::string device_id;                   // "<ip>:<port>", key of ws_session_map; tells apart devices on one address
+	std::shared_ptr<OutboundQueue> outbound; // Thread-safe, the only way handlers should write to ws
+	AdmissionTicket admission;               // Reset by on_session_created() to refuse the session and close it
 };
 
 // -- Global State --
-extern bool flag_stop_server;            // Server Stop Flag for logging
-extern ServerConfig ws_server_config;    // Server configuration
-extern SessionMap ws_session_map;        // Session map
-extern TimePoint ws_last_session_logged; // Last time a session logged
+extern bool flag_stop_server;                              // Server Stop Flag for logging
+extern ServerConfig ws_server_config;                      // Server configuration
+extern SessionMap ws_session_map;                          // Identified sessions by device_id
+extern std::atomic<std::shared_ptr<BufferPool>> ws_buffer_pool; // Pool of the running server, read for stats only
+extern std::atomic<std::uint64_t> ws_rejected_connections;      // Connections turned away before the upgrade
 
 // -- Session Event Handlers --
+AdmissionTicket on_session_admit(const UpgradeRequest& request,
+                                 const std::string& device_ip); // Before the upgrade, empty ticket: HTTP 503
 void on_session_created(const std::shared_ptr<Session>& session,
                         const std::shared_ptr<Buffer>& buffer); // Called when a session is created
 void on_session_read(const std::shared_ptr<Session>& session,
                      const std::shared_ptr<Buffer>& buffer); // Called when a session receives data
+void on_session_closed(const std::shared_ptr<Session>& session); // Called once the session's connection has ended
 
 // -- Session Management --
-void on_session_manage(); // Periodic session management (timeout, cleanup, etc.)
+void on_session_manage(); // Periodic session summary (expiry itself is driven by per-connection timers)
 } // namespace WebSocketServerContext
 
 class WebSocketServer
@@ -63,7 +88,6 @@ class WebSocketServer
 
   protected:
 	WebSocketServer() = default;
-	std::shared_ptr<std::jthread> periodic_session_manage_thread_;
 };
 
 class WebSocketConnection
@@ -1,14 +1,26 @@
 #pragma once
+#include <array>
 #include <boost/asio/io_context.hpp>
 #include <fmt/core.h>
 #include <memory>
+#include <mutex>
 #include <opencv2/opencv.hpp>
 #include <optional>
 #include <tbb/concurrent_queue.h>
 #include <thread>
 
 #include "server/async_websocket_server.hpp"
+#include "server/metrics_server.hpp"
+#include "utils/frame_mailbox.hpp"
 #include "utils/logging_utils.hpp"
+#include "vision/fall_detector.hpp"
+#include "vision/keypoint_history.hpp"
+#include "vision/display_compositor.hpp"
+#include "vision/inference_region.hpp"
+#include "vision/keypoint_tracker.hpp"
+#include "vision/motion_gate.hpp"
+#include "vision/person_follower.hpp"
+#include "vision/pose_backend.hpp"
 
 namespace SolicareHomeHub
 {
@@ -67,6 +79,30 @@ enum SESSION_TYPE
 	SESSION_CAMERA,
 	SESSION_WEARABLE
 };
+
+// Admission slot backing the server's AdmissionTicket: counts against max_session and, once the device type is known,
+// against its per-type quota. Released when the connection is gone.
+struct AdmissionSlot
+{
+	SESSION_TYPE type = SESSION_NOT_IDENTIFIED;
+	~AdmissionSlot();
+};
+
+std::shared_ptr<AdmissionSlot> try_admit(SESSION_TYPE type);
+bool try_assign_type(AdmissionSlot& slot, SESSION_TYPE type); // For devices that did not announce their type early
+
+// Identification field ("CAM;ACK", "WEARABLE;ACK") asking the hub to acknowledge every processed frame with
+// {"ack":<n>}, n being the 1-based index of the frame after the identification message. Used by load generators.
+inline constexpr std::string_view ACK_TOKEN = "ACK";
+
+// Queues {"command": command, "argument": argument} for the device with session device_id, e.g. ("set_fps", "5").
+// A newer command with the same name replaces one that has not been sent yet.
+// Returns false if the device is not connected or its outbound queue is full.
+// The hub itself sends LOWER_FPS_COMMAND to cameras whose frames it mostly has to drop, see on_session_manage().
+inline constexpr std::string_view LOWER_FPS_COMMAND = "lower_fps";
+bool send_device_command(const std::string& device_id, const std::string& command, const std::string& argument = {});
+
+void register_metrics(); // Session, admission, buffer pool and monitor queue series of the /metrics endpoint
 } // namespace SessionManager
 
 namespace CameraProcessor
@@ -74,10 +110,37 @@ namespace CameraProcessor
 inline constexpr std::string_view TAG = "CameraProcessor";
 inline constexpr auto LOG_COLOR       = Logger::ConsoleColor::TEAL;
 
-inline constexpr int MAX_BODY_POINT          = 30;
-inline constexpr auto YOLOV8_POSE_MODEL_PATH = "../models/yolov8n-pose.onnx";
+inline constexpr int MAX_BODY_POINT = 30; // Frames of keypoint history kept per camera, covers the fall detector window
+
+// Frames of one camera that may be between the mailbox and the monitor handoff at the same time, so that
+// the next frame decodes while the previous one is still in inference
+inline constexpr unsigned MAX_FRAMES_IN_FLIGHT = 2;
+
+// Frames of all cameras are run through the pose model together, a batch is flushed once it is full or its oldest
+// frame has waited for the delay
+inline constexpr std::size_t INFERENCE_MAX_BATCH_SIZE                 = 4;
+inline constexpr std::chrono::microseconds INFERENCE_MAX_BATCH_DELAY = std::chrono::milliseconds(4);
+
+// Overridden by SOLICARE_POSE_BACKEND / SOLICARE_POSE_PRECISION / SOLICARE_POSE_THREADS
+extern PoseBackendConfig pose_backend_config;
+extern std::unique_ptr<PoseBackend> pose_backend; // Empty if no model could be loaded, camera frames are dropped
+// Second instance of the model for the crops of cropped inference, so neither instance reshapes or recompiles its
+// network each time full frames and crops alternate. Empty: crops run on pose_backend.
+extern std::unique_ptr<PoseBackend> crop_pose_backend;
 
-extern std::optional<cv::dnn::Net> pose_net;
+// Motion gate of every camera, SOLICARE_MOTION_GATE=0 disables it. A camera can tune its own gate with tokens in its
+// identification message: "CAM;MOTION=0.01;HEARTBEAT=5" (changed pixel fraction, seconds between static inferences).
+extern MotionGateConfig motion_gate_config;
+inline constexpr std::string_view MOTION_THRESHOLD_TOKEN = "MOTION=";
+inline constexpr std::string_view HEARTBEAT_TOKEN        = "HEARTBEAT=";
+[[nodiscard]] MotionGateConfig motion_gate_config_for(std::string_view identification);
+
+// Keypoint tracker of every camera, SOLICARE_KEYPOINT_TRACKER=0 runs the pose model on every frame with motion
+extern KeypointTrackerConfig keypoint_tracker_config;
+
+// Cropped inference around the followed person, SOLICARE_ROI_INFERENCE=0 always runs the full frame. Also disabled
+// at startup when the model does not accept the smaller input.
+extern InferenceRegionConfig inference_region_config;
 
 enum PersonPosture
 {
@@ -92,8 +155,83 @@ struct CameraSessionData
 {
 	std::string device_tag;
 	PersonPosture pose = UNKNOWN;
-	std::deque<std::vector<cv::Point2f>> body_points;
 };
+
+struct CameraFrame
+{
+	std::shared_ptr<WebSocketServerContext::Buffer> buffer;
+	std::uint64_t sequence; // 1-based index among the frames received from this camera
+};
+
+// Images of one frame in flight, reused by the camera's later frames so decoding and preprocessing do not allocate
+struct CameraFrameBuffers
+{
+	cv::Mat decoded;    // Reduced-resolution decode
+	cv::Mat full;       // Full-resolution decode, only while crops around a followed person are taken
+	cv::Mat tensor;     // Model input, [1, 3, 640, 640] float
+	cv::Mat roi_tensor; // Model input of a crop, [1, 3, 320, 320] float
+	cv::Mat gray;       // Grayscale of decoded, followed by the keypoint tracker
+};
+
+// Per-camera processing state, CameraSessionData is the part handed over to the monitor
+struct CameraSessionState
+{
+	CameraSessionData data;                      // Owned by the classify stage of the pipeline, under classify_mutex
+	KeypointHistory<MAX_BODY_POINT> body_points; // Followed person of the last frames, owned like data
+	FallDetector fall_detector;                  // Classifies data.pose from body_points, owned like data
+	PersonFollower person_follower;              // Which of the people in view is followed, owned like data
+	MotionGate motion_gate;                      // Decides which frames skip the pose model
+	KeypointTracker keypoint_tracker;            // Follows the person between pose model runs
+	InferenceRegion inference_region;            // Crops the model input around the followed person
+	FrameMailbox<CameraFrame> mailbox;           // Latest received, unprocessed frame
+
+	std::atomic_uint frames_in_flight = 0; // Taken from the mailbox, not handed off to the monitor yet
+	std::mutex classify_mutex;             // Classifies one frame of this camera at a time, other cameras run along
+	std::uint64_t last_sequence       = 0; // Last detected or tracked frame, older ones finishing late are discarded
+	std::uint64_t last_displayed      = 0; // Last frame published by the serial display stage
+
+	// Mailbox counters at the last on_session_manage(), which alone touches them
+	std::uint64_t posted_at_last_check  = 0;
+	std::uint64_t dropped_at_last_check = 0;
+
+	std::array<CameraFrameBuffers, MAX_FRAMES_IN_FLIGHT> frame_buffers;
+	std::atomic_uint free_frame_buffers = (1u << MAX_FRAMES_IN_FLIGHT) - 1; // Bit i: frame_buffers[i] is free
+};
+
+// Camera processing as a TBB flow graph: decode -> motion gate -> preprocess -> pose inference -> postprocess ->
+// posture classification -> display -> monitor handoff. Frames the motion gate finds static skip preprocess,
+// inference and postprocess, the camera keeps its last posture for them. Of the other frames only every few go
+// through the pose model, the keypoint tracker follows the person on the ones in between during classification.
+// Once a person is found, preprocess crops the model input around them until they are lost.
+// Decode, preprocess, postprocess and classification run frames of every camera in parallel with bounded
+// concurrency, classification one frame per camera at a time so its optical flow never waits for other cameras.
+// Inference is handed to a PoseInferenceService that batches the frames of all cameras, the display handoff to the
+// DisplayCompositor is serial. Each stage is timed into solicare_camera_stage_seconds{stage="..."}.
+class CameraPipeline
+{
+  public:
+	explicit CameraPipeline(std::size_t parallel_frames); // Concurrency of the parallel stages
+	~CameraPipeline();                                    // Waits for the frames in flight
+
+	// Takes the camera's next frame from its mailbox into the graph, called whenever the mailbox wakes its consumer.
+	// Up to MAX_FRAMES_IN_FLIGHT frames of a camera are processed at once, the graph keeps pulling from the
+	// mailbox until it is empty.
+	void feed(const std::shared_ptr<WebSocketServerContext::SessionInfo>& session_info,
+	          const std::shared_ptr<CameraSessionState>& camera);
+
+	void wait_for_all();
+
+  private:
+	struct Graph;
+	std::unique_ptr<Graph> graph_;
+};
+
+extern std::optional<CameraPipeline> pipeline;
+
+// Camera windows, drawn by the compositor's own thread. SOLICARE_HEADLESS=1 (or no display on Linux) makes no HighGUI
+// call at all; SOLICARE_DISPLAY_FPS caps the refresh rate, SOLICARE_DISPLAY_MOSAIC=1 tiles every camera in one window.
+extern DisplayConfig display_config;
+extern std::optional<DisplayCompositor> display_compositor; // Empty when headless
 } // namespace CameraProcessor
 
 namespace WearableProcessor
@@ -101,6 +239,38 @@ namespace WearableProcessor
 inline constexpr std::string_view TAG = "WearableProcessor";
 inline constexpr auto LOG_COLOR       = Logger::ConsoleColor::BROWN;
 
+// Telemetry encoding, negotiated by the identification message ("WEARABLE" = JSON, "WEARABLE;BIN1" = binary v1)
+enum WEARABLE_PROTOCOL
+{
+	PROTOCOL_JSON,
+	PROTOCOL_BINARY_V1
+};
+
+inline constexpr std::string_view PROTOCOL_BINARY_V1_TOKEN = "BIN1";
+
+// Binary telemetry frame v1, little-endian, 32 bytes, sent as a WebSocket binary message:
+// [0] type(u8) [1] version(u8) [2] flags(u16) [4] sequence(u32) [8] device_timestamp_ms(u64)
+// [16] heart_rate_bpm(f32) [20] body_temperature(f32) [24] air_humidity(f32) [28] battery_percentage(f32)
+namespace BinaryFrameV1
+{
+inline constexpr std::size_t SIZE            = 32;
+inline constexpr std::uint8_t TYPE_TELEMETRY = 0x01;
+inline constexpr std::uint8_t VERSION        = 1;
+
+inline constexpr std::uint16_t FLAG_WEARING       = 1u << 0;
+inline constexpr std::uint16_t FLAG_FALL_DETECTED = 1u << 1;
+
+inline constexpr std::size_t OFFSET_TYPE      = 0;
+inline constexpr std::size_t OFFSET_VERSION   = 1;
+inline constexpr std::size_t OFFSET_FLAGS     = 2;
+inline constexpr std::size_t OFFSET_SEQUENCE  = 4;
+inline constexpr std::size_t OFFSET_TIMESTAMP = 8;
+inline constexpr std::size_t OFFSET_BPM       = 16;
+inline constexpr std::size_t OFFSET_TEMP      = 20;
+inline constexpr std::size_t OFFSET_HUMIDITY  = 24;
+inline constexpr std::size_t OFFSET_BATTERY   = 28;
+} // namespace BinaryFrameV1
+
 struct WearableSessionData
 {
 	bool is_wearing;
@@ -109,6 +279,10 @@ struct WearableSessionData
 	double body_temperature;
 	double air_humidity;
 	double battery_percentage;
+
+	WEARABLE_PROTOCOL protocol        = PROTOCOL_JSON;
+	std::uint32_t sequence            = 0; // Binary protocol only
+	std::uint64_t device_timestamp_ms = 0; // Binary protocol only
 };
 } // namespace WearableProcessor
 
@@ -138,12 +312,20 @@ extern std::atomic<std::chrono::steady_clock::time_point> wearable_last_data_pus
 struct WebSocketServerContext::SessionInfo
 {
 	using SessionType  = SolicareHomeHub::SessionManager::SESSION_TYPE;
-	using CameraData   = SolicareHomeHub::CameraProcessor::CameraSessionData;
+	using CameraState  = SolicareHomeHub::CameraProcessor::CameraSessionState;
 	using WearableData = SolicareHomeHub::WearableProcessor::WearableSessionData;
 
 	SessionType type = SolicareHomeHub::SessionManager::SESSION_TYPE::SESSION_NOT_IDENTIFIED;
-	std::variant<std::monostate, std::string, std::shared_ptr<CameraData>, std::shared_ptr<WearableData>> data{};
-	TimePoint timepoint_connected, timepoint_last_received, timepoint_last_processed, timepoint_disconnected;
+	std::variant<std::monostate, std::string, std::shared_ptr<CameraState>, std::shared_ptr<WearableData>> data{};
+	// Written by the connection's io thread, read concurrently by on_session_manage()
+	std::atomic<TimePoint> timepoint_connected, timepoint_last_received, timepoint_last_processed,
+	    timepoint_disconnected;
+
+	// Written by the connection's io thread only, read by the /metrics collector
+	std::atomic<std::uint64_t> frames_received = 0, bytes_received = 0;
+
+	std::shared_ptr<OutboundQueue> ack_queue;       // Set if the device asked for frame acknowledgements
+	void acknowledge(std::uint64_t sequence) const; // No-op unless ack_queue is set
 };
 
 class SolicareCentralHomeHub
@@ -151,10 +333,10 @@ class SolicareCentralHomeHub
   public:
 	SolicareCentralHomeHub();
 	~SolicareCentralHomeHub();
-	static void process_image(const std::shared_ptr<WebSocketServerContext::SessionInfo>& session_info,
-	                          const std::shared_ptr<WebSocketServerContext::Buffer>& buffer);
+	static void submit_image(const std::shared_ptr<WebSocketServerContext::SessionInfo>& session_info,
+	                         SolicareHomeHub::CameraProcessor::CameraFrame frame);
 	static void process_wearable(const std::shared_ptr<WebSocketServerContext::SessionInfo>& session_info,
-	                             const std::shared_ptr<WebSocketServerContext::Buffer>& buffer);
+	                             const std::shared_ptr<WebSocketServerContext::Buffer>& buffer, bool is_text);
 	void login();
 	void runtime();
 	void start_monitoring();
@@ -164,6 +346,8 @@ class SolicareCentralHomeHub
 	boost::asio::io_context ioc_;
 	std::thread io_context_run_thread_;
 	std::optional<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> ioc_work_guard_;
+	std::unique_ptr<IoContextPool> ws_io_context_pool_; // Runs WebSocket connections across cores
+	std::shared_ptr<MetricsServer> metrics_server_;     // Served from ioc_
 
 	std::thread monitoring_thread_;
 	std::atomic_bool monitoring_active_;
@@ -0,0 +1,39 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Usage Example:
+// const auto* bytes = static_cast<const std::byte*>(buffer.data());
+// auto sequence = BinaryUtils::read_le<std::uint32_t>(bytes + 4);
+// auto bpm      = BinaryUtils::read_le<float>(bytes + 16);
+//
+// read_le: Reads a little-endian integer or IEEE-754 float from an unaligned position, without copying the
+// surrounding message. On little-endian hosts this compiles down to a single load.
+namespace BinaryUtils
+{
+template <typename T>
+    requires std::is_arithmetic_v<T>
+inline T read_le(const std::byte* source)
+{
+	using Raw = std::conditional_t<sizeof(T) == 1, std::uint8_t,
+	                               std::conditional_t<sizeof(T) == 2, std::uint16_t,
+	                                                  std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>>;
+	static_assert(sizeof(Raw) == sizeof(T));
+
+	Raw raw;
+	std::memcpy(&raw, source, sizeof(Raw));
+	if constexpr (std::endian::native == std::endian::big && sizeof(Raw) > 1)
+	{
+		Raw swapped = 0;
+		for (std::size_t i = 0; i < sizeof(Raw); ++i)
+		{
+			swapped = static_cast<Raw>((swapped << 8) | ((raw >> (8 * i)) & 0xFF));
+		}
+		raw = swapped;
+	}
+	return std::bit_cast<T>(raw);
+}
+} // namespace BinaryUtils
@@ -0,0 +1,36 @@
+#pragma once
+
+// Usage Example:
+// #if defined(SOLICARE_AVX2_KERNELS)
+// SOLICARE_TARGET_AVX2 int sum_avx2(const float* values, int count) { /* _mm256_... */ }
+// #endif
+// if (CpuFeatures::has_avx2())
+//     done = sum_avx2(values, count);
+//
+// x86-64 SIMD kernels are compiled next to the baseline code instead of raising the instruction set of the whole
+// build, so the same binary runs on hubs without AVX2. SOLICARE_AVX2_KERNELS (CMake option SOLICARE_ENABLE_AVX2)
+// compiles them; a kernel is marked SOLICARE_TARGET_AVX2 and only called once has_avx2() confirmed the CPU runs it.
+// NEON is part of the AArch64 baseline and stays a compile-time choice.
+
+#if defined(SOLICARE_AVX2_KERNELS)
+#include <immintrin.h>
+#define SOLICARE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+namespace CpuFeatures
+{
+// AVX2 and FMA, detected on the first call
+inline bool has_avx2()
+{
+#if defined(SOLICARE_AVX2_KERNELS)
+	static const bool supported = []
+	{
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	}();
+	return supported;
+#else
+	return false;
+#endif
+}
+} // namespace CpuFeatures
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+// Usage Example:
+// FrameMailbox<std::shared_ptr<Buffer>> mailbox;
+// if (mailbox.post(buffer).wake_consumer) { /* schedule a consumer */ }
+// while (auto frame = mailbox.take()) { /* process *frame */ }
+//
+// Single-slot, latest-value-wins mailbox between a producer (the read loop) and one consumer.
+// post() never blocks on the consumer: a frame that was not taken yet is overwritten and counted as dropped.
+// take() hands out the newest frame; once the slot is empty it marks the consumer idle, so the next post()
+// reports that a consumer has to be scheduled again. At most one consumer is therefore active at a time.
+template <typename T>
+class FrameMailbox
+{
+  public:
+	struct PostResult
+	{
+		bool dropped_previous; // An unprocessed frame was replaced
+		bool wake_consumer;    // No consumer is running, the caller has to schedule one
+	};
+
+	PostResult post(T frame)
+	{
+		PostResult result{};
+		{
+			std::lock_guard lock(mutex_);
+			result.dropped_previous = slot_.has_value();
+			result.wake_consumer    = !consumer_active_;
+			slot_                   = std::move(frame);
+			consumer_active_        = true;
+		}
+		posted_.fetch_add(1, std::memory_order_relaxed);
+		if (result.dropped_previous)
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+		return result;
+	}
+
+	std::optional<T> take()
+	{
+		std::lock_guard lock(mutex_);
+		if (!slot_)
+		{
+			consumer_active_ = false;
+			return std::nullopt;
+		}
+		std::optional<T> frame = std::move(slot_);
+		slot_.reset();
+		return frame;
+	}
+
+	[[nodiscard]] std::uint64_t posted() const
+	{
+		return posted_.load(std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] std::uint64_t dropped() const
+	{
+		return dropped_.load(std::memory_order_relaxed);
+	}
+
+  private:
+	std::mutex mutex_;
+	std::optional<T> slot_;
+	bool consumer_active_ = false;
+
+	std::atomic<std::uint64_t> posted_  = 0;
+	std::atomic<std::uint64_t> dropped_ = 0;
+};
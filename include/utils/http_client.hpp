@@ -8,6 +8,8 @@
 #include <string>
 #include <unordered_map>
 
+#include "metrics.hpp"
+
 // Usage Example:
 // auto res = HttpClient::requestHttp(ioc, host, Method::GET, "/api", "", 3000);
 // if (res.error) { /* error handling */ }
@@ -20,6 +22,7 @@
 // All functions support timeout (ms)
 //
 // Returns std::nullopt on error, otherwise HttpsResponse
+// Latency and failures are recorded in Metrics::registry() (solicare_http_client_*)
 //
 // Requires boost::asio, boost::beast
 namespace HttpClient
@@ -44,7 +47,7 @@ struct HttpResponse
 
 namespace HttpClientImpl
 {
-inline HttpResponse requestImpl(boost::asio::io_context& ioc, const std::string& host, Method method,
+inline HttpResponse sendRequest(boost::asio::io_context& ioc, const std::string& host, Method method,
                                 const std::string& uri_path, const std::string& body, bool use_ssl,
                                 const std::string& auth_token, int timeout_ms)
 {
@@ -144,6 +147,36 @@ inline HttpResponse requestImpl(boost::asio::io_context& ioc, const std::string&
 		return HttpResponse{-1, std::nullopt, std::make_optional<std::string>("Unknown error")};
 	}
 }
+
+inline Metrics::Histogram& requestLatency(const Method method)
+{
+	static const auto histograms = []()
+	{
+		auto& registry      = Metrics::registry();
+		constexpr auto name = "solicare_http_client_request_seconds";
+		constexpr auto help = "HTTP API call latency, including connect and TLS handshake";
+		return std::array<Metrics::Histogram*, 4>{
+		    &registry.histogram(name, help, R"(method="GET")"), &registry.histogram(name, help, R"(method="POST")"),
+		    &registry.histogram(name, help, R"(method="PUT")"), &registry.histogram(name, help, R"(method="DELETE")")};
+	}();
+	return *histograms[static_cast<std::size_t>(method) % histograms.size()];
+}
+
+inline HttpResponse requestImpl(boost::asio::io_context& ioc, const std::string& host, const Method method,
+                                const std::string& uri_path, const std::string& body, const bool use_ssl,
+                                const std::string& auth_token, const int timeout_ms)
+{
+	static auto& failures = Metrics::registry().counter("solicare_http_client_failures_total",
+	                                                    "HTTP API calls that failed or returned a non-2xx status");
+	const auto started = std::chrono::steady_clock::now();
+	auto response      = sendRequest(ioc, host, method, uri_path, body, use_ssl, auth_token, timeout_ms);
+	requestLatency(method).observe(std::chrono::steady_clock::now() - started);
+	if (response.error || response.status < 200 || response.status >= 300)
+	{
+		failures.add();
+	}
+	return response;
+}
 } // namespace HttpClientImpl
 
 inline HttpResponse requestHttp(boost::asio::io_context& ioc, const std::string& host, const Method method,
@@ -1,9 +1,34 @@
 #pragma once
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <fmt/core.h>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
+
+// Usage Example:
+// Logger::log_info(TAG, fmt::format("connected: {}", ip), Logger::ConsoleColor::GREEN);
+// Logger::info(TAG, Logger::ConsoleColor::GREEN, "connected: {}", ip); // Formats only if the record is emitted
+// Logger::debug(TAG, "queue depth: {}", depth);                        // Compiled out below SOLICARE_LOG_MIN_LEVEL
+//
+// Logger::start_async_logging(8192, Logger::OverflowPolicy::DROP); // Optional, e.g. at the top of main()
+// ...
+// Logger::flush();              // Before writing to std::cout directly (menus, prompts)
+// Logger::stop_async_logging(); // Drains the queue, log_* are synchronous again
+//
+// Synchronous mode (default): every call formats and writes the line under log_mutex.
+// Asynchronous mode: log_* only move the record into a bounded lock-free MPSC ring; a background thread formats
+// the timestamp and colors and writes whole batches with a single flush. When the ring is full, records are
+// either dropped (counted and reported) or the caller waits for free space, depending on the OverflowPolicy.
+// Each stream keeps the order records were logged in, but a batch writes its std::cout lines before its std::cerr
+// lines: with both streams on one terminal, an error can show up ahead of info lines logged just before it.
 
 namespace Logger
 {
@@ -100,33 +125,367 @@ inline std::string colored_text_rgb(const int r, const int g, const int b, const
 	       "\033[0m";
 }
 
-inline void log_info(const std::string_view tag, const std::string& message,
-                     const ConsoleColor color = ConsoleColor::GRAY)
+enum class OverflowPolicy
+{
+	DROP,  // Never stall the caller, the number of dropped records is reported by the writer thread
+	BLOCK, // Wait until the writer thread frees a slot
+};
+
+namespace AsyncLogging
+{
+struct Record
+{
+	std::chrono::system_clock::time_point time;
+	ConsoleColor color;
+	bool is_error;
+	std::string tag;
+	std::string message;
+};
+
+// Bounded multi-producer/single-consumer ring, a producer claims a cell with one CAS and never takes a lock
+class RecordRing
+{
+  public:
+	explicit RecordRing(std::size_t capacity)
+	{
+		std::size_t size = 2;
+		while (size < capacity)
+			size <<= 1;
+		mask_  = size - 1;
+		cells_ = std::make_unique<Cell[]>(size);
+		for (std::size_t i = 0; i < size; ++i)
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	bool try_push(Record& record)
+	{
+		auto position = enqueue_position_.load(std::memory_order_relaxed);
+		while (true)
+		{
+			auto& cell          = cells_[position & mask_];
+			const auto sequence = cell.sequence.load(std::memory_order_acquire);
+			const auto diff     = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+			if (diff == 0)
+			{
+				if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					cell.record = std::move(record);
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false; // Full
+			}
+			else
+			{
+				position = enqueue_position_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool try_pop(Record& record) // Consumer thread only
+	{
+		auto& cell = cells_[dequeue_position_ & mask_];
+		if (cell.sequence.load(std::memory_order_acquire) != dequeue_position_ + 1)
+			return false; // Empty
+		record = std::move(cell.record);
+		cell.sequence.store(dequeue_position_ + mask_ + 1, std::memory_order_release);
+		++dequeue_position_;
+		return true;
+	}
+
+  private:
+	struct Cell
+	{
+		std::atomic<std::size_t> sequence;
+		Record record;
+	};
+
+	std::unique_ptr<Cell[]> cells_;
+	std::size_t mask_ = 0;
+	alignas(64) std::atomic<std::size_t> enqueue_position_ = 0;
+	alignas(64) std::size_t dequeue_position_              = 0;
+};
+
+struct State
+{
+	std::unique_ptr<RecordRing> ring;
+	OverflowPolicy policy               = OverflowPolicy::DROP;
+	std::atomic<std::uint64_t> dropped  = 0;
+	std::atomic<std::uint64_t> accepted = 0; // Records in the ring or already written, flush() waits on written
+	std::atomic<std::uint64_t> written  = 0;
+	std::atomic<std::size_t> producers  = 0; // Threads inside enqueue(), stop waits for them
+	std::atomic_bool running            = false;
+	std::atomic_bool writer_idle        = false;
+	std::mutex lifecycle_mutex; // Serializes start and stop
+	std::mutex wake_mutex;
+	std::condition_variable wake;
+	std::thread writer;
+};
+
+inline std::atomic_bool active = false;
+inline State state;
+
+inline constexpr auto WRITER_IDLE_WAIT  = std::chrono::milliseconds(20);
+inline constexpr std::size_t BATCH_SIZE = 256;
+
+// Formats like current_timestamp(), but only once per second
+inline const std::string& cached_timestamp(const std::chrono::system_clock::time_point time)
+{
+	static std::time_t cached_second = -1;
+	static std::string cached;
+	const auto second = std::chrono::system_clock::to_time_t(time);
+	if (second != cached_second)
+	{
+		std::stringstream ss;
+		{
+			// std::localtime() shares one buffer, synchronous records call it under log_mutex
+			std::lock_guard lock(log_mutex);
+			ss << std::put_time(std::localtime(&second), "%Y-%m-%d %H:%M:%S");
+		}
+		cached        = ss.str();
+		cached_second = second;
+	}
+	return cached;
+}
+
+inline void write_batch(std::string& out, std::string& err)
 {
-	if (!log_tag_filter.empty() && tag != log_tag_filter)
-		return;
 	std::lock_guard lock(log_mutex);
-	std::cout << colored_text(color, "[" + current_timestamp() + "] [" + std::string(tag) + "] " + message)
-	          << std::endl;
+	if (!out.empty())
+	{
+		std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+		std::cout.flush();
+	}
+	if (!err.empty())
+	{
+		std::cerr.write(err.data(), static_cast<std::streamsize>(err.size()));
+		std::cerr.flush();
+	}
+	out.clear();
+	err.clear();
+}
+
+inline void run_writer()
+{
+	std::string out, err;
+	Record record;
+	std::uint64_t reported_dropped = 0;
+	while (true)
+	{
+		// Read before the pass: once stop has cleared running, every record is already in the ring
+		const bool stopping = !state.running.load(std::memory_order_acquire);
+		std::size_t count   = 0;
+		while (count < BATCH_SIZE && state.ring->try_pop(record))
+		{
+			const auto line = "[" + cached_timestamp(record.time) + "] [" + record.tag + "] " + record.message;
+			(record.is_error ? err : out) += colored_text(record.color, line) + "\n";
+			++count;
+		}
+		if (const auto dropped = state.dropped.load(std::memory_order_relaxed); dropped != reported_dropped)
+		{
+			out += colored_text(ConsoleColor::ORANGE,
+			                    "[" + cached_timestamp(std::chrono::system_clock::now()) + "] [Logger] " +
+			                        std::to_string(dropped - reported_dropped) + " log record(s) dropped, queue full") +
+			       "\n";
+			reported_dropped = dropped;
+		}
+		if (!out.empty() || !err.empty())
+			write_batch(out, err);
+		state.written.fetch_add(count, std::memory_order_release);
+
+		if (count == BATCH_SIZE)
+			continue;
+		if (stopping)
+			return; // Drained
+		// Producers only notify an idle writer, the timeout bounds the latency of a missed notification
+		std::unique_lock lock(state.wake_mutex);
+		state.writer_idle.store(true, std::memory_order_relaxed);
+		state.wake.wait_for(lock, WRITER_IDLE_WAIT);
+		state.writer_idle.store(false, std::memory_order_relaxed);
+	}
+}
+
+// Returns false if asynchronous logging is off, the caller then writes synchronously
+inline bool enqueue(const ConsoleColor color, const bool is_error, const std::string_view tag, std::string&& message)
+{
+	// Announced before active is checked, so stop either sees this producer or this producer sees stop
+	state.producers.fetch_add(1);
+	struct Leave
+	{
+		~Leave() { state.producers.fetch_sub(1, std::memory_order_release); }
+	} leave;
+	if (!active.load())
+		return false;
+
+	Record record{std::chrono::system_clock::now(), color, is_error, std::string(tag), std::move(message)};
+	while (!state.ring->try_push(record))
+	{
+		if (state.policy == OverflowPolicy::DROP)
+		{
+			state.dropped.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		// The writer runs until every producer has left, a slot frees up eventually
+		state.wake.notify_one();
+		std::this_thread::yield();
+	}
+	state.accepted.fetch_add(1, std::memory_order_release);
+	if (state.writer_idle.load(std::memory_order_relaxed))
+		state.wake.notify_one();
+	return true;
 }
+} // namespace AsyncLogging
 
-inline void log_warn(const std::string_view tag, const std::string& message)
+inline void start_async_logging(const std::size_t capacity = 8192, const OverflowPolicy policy = OverflowPolicy::DROP)
 {
-	if (!log_tag_filter.empty() && tag != log_tag_filter)
+	using namespace AsyncLogging;
+	std::lock_guard lock(state.lifecycle_mutex);
+	if (active.load())
 		return;
-	std::lock_guard lock(log_mutex);
-	std::cout << colored_text(ConsoleColor::ORANGE,
-	                          "[" + current_timestamp() + "] [" + std::string(tag) + "] " + message)
-	          << std::endl;
+	// No producer can be using the previous ring: enqueue() only touches it while active, and stop waited for them
+	state.ring   = std::make_unique<RecordRing>(capacity);
+	state.policy = policy;
+	state.running.store(true);
+	state.writer = std::thread(run_writer);
+	active.store(true, std::memory_order_release);
 }
 
-inline void log_error(const std::string_view tag, const std::string& message)
+// Waits until every record logged so far has been written
+inline void flush()
 {
-	if (!log_tag_filter.empty() && tag != log_tag_filter)
+	using namespace AsyncLogging;
+	if (!active.load(std::memory_order_acquire))
+		return;
+	// Only accepted records count, one dropped by a full ring would never be written
+	const auto target = state.accepted.load(std::memory_order_acquire);
+	state.wake.notify_one();
+	while (state.written.load(std::memory_order_acquire) < target)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+// Writes everything still queued, later calls log synchronously again
+inline void stop_async_logging()
+{
+	using namespace AsyncLogging;
+	std::lock_guard lock(state.lifecycle_mutex);
+	if (!active.exchange(false))
+		return;
+	// A producer that still saw active pushes into the ring while the writer keeps draining it
+	while (state.producers.load() != 0)
+	{
+		state.wake.notify_one();
+		std::this_thread::yield();
+	}
+	state.running.store(false, std::memory_order_release);
+	state.wake.notify_one();
+	if (state.writer.joinable())
+		state.writer.join();
+}
+
+inline bool is_tag_enabled(const std::string_view tag)
+{
+	return log_tag_filter.empty() || tag == log_tag_filter;
+}
+
+// Writes an already filtered record, asynchronously if enabled
+inline void emit(const ConsoleColor color, const bool is_error, const std::string_view tag, std::string message)
+{
+	if (AsyncLogging::enqueue(color, is_error, tag, std::move(message)))
 		return;
 	std::lock_guard lock(log_mutex);
-	std::cerr << colored_text(ConsoleColor::RED, "[" + current_timestamp() + "] [" + std::string(tag) + "] " + message)
-	          << std::endl;
+	(is_error ? std::cerr : std::cout) << colored_text(color, "[" + current_timestamp() + "] [" + std::string(tag) +
+	                                                              "] " + message)
+	                                   << std::endl;
+}
+
+inline void log_info(const std::string_view tag, std::string message, const ConsoleColor color = ConsoleColor::GRAY)
+{
+	if (is_tag_enabled(tag))
+		emit(color, false, tag, std::move(message));
+}
+
+inline void log_warn(const std::string_view tag, std::string message)
+{
+	if (is_tag_enabled(tag))
+		emit(ConsoleColor::ORANGE, false, tag, std::move(message));
+}
+
+inline void log_error(const std::string_view tag, std::string message)
+{
+	if (is_tag_enabled(tag))
+		emit(ConsoleColor::RED, true, tag, std::move(message));
+}
+
+// -- Leveled, lazily formatted logging --
+// Logger::info(TAG, "connected: {}", ip);  Logger::info(TAG, LOG_COLOR, "connected: {}", ip);
+// The message is only formatted once the record passes the level and tag filters. Levels below
+// SOLICARE_LOG_MIN_LEVEL (0 trace .. 4 error, default: info in Release, trace otherwise) compile to nothing.
+enum class LogLevel
+{
+	LEVEL_TRACE,
+	LEVEL_DEBUG,
+	LEVEL_INFO,
+	LEVEL_WARN,
+	LEVEL_ERROR
+};
+
+#ifndef SOLICARE_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define SOLICARE_LOG_MIN_LEVEL 2
+#else
+#define SOLICARE_LOG_MIN_LEVEL 0
+#endif
+#endif
+inline constexpr auto MIN_LOG_LEVEL = static_cast<LogLevel>(SOLICARE_LOG_MIN_LEVEL);
+
+template <LogLevel Level, typename... Args>
+void log_lazy(const std::string_view tag, const ConsoleColor color, fmt::format_string<Args...> format,
+              Args&&... args)
+{
+	if constexpr (Level >= MIN_LOG_LEVEL)
+	{
+		if (is_tag_enabled(tag))
+			emit(color, Level == LogLevel::LEVEL_ERROR, tag, fmt::format(format, std::forward<Args>(args)...));
+	}
+}
+
+template <typename... Args>
+void trace(const std::string_view tag, fmt::format_string<Args...> format, Args&&... args)
+{
+	log_lazy<LogLevel::LEVEL_TRACE>(tag, ConsoleColor::GRAY, format, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+void debug(const std::string_view tag, fmt::format_string<Args...> format, Args&&... args)
+{
+	log_lazy<LogLevel::LEVEL_DEBUG>(tag, ConsoleColor::GRAY, format, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+void info(const std::string_view tag, fmt::format_string<Args...> format, Args&&... args)
+{
+	log_lazy<LogLevel::LEVEL_INFO>(tag, ConsoleColor::GRAY, format, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+void info(const std::string_view tag, const ConsoleColor color, fmt::format_string<Args...> format, Args&&... args)
+{
+	log_lazy<LogLevel::LEVEL_INFO>(tag, color, format, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+void warn(const std::string_view tag, fmt::format_string<Args...> format, Args&&... args)
+{
+	log_lazy<LogLevel::LEVEL_WARN>(tag, ConsoleColor::ORANGE, format, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+void error(const std::string_view tag, fmt::format_string<Args...> format, Args&&... args)
+{
+	log_lazy<LogLevel::LEVEL_ERROR>(tag, ConsoleColor::RED, format, std::forward<Args>(args)...);
 }
 
 inline void preview_all_colors()
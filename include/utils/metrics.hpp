@@ -0,0 +1,257 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fmt/core.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Usage Example:
+// static auto& frames  = Metrics::registry().counter("solicare_frames_total", "Frames received", R"(type="camera")");
+// static auto& latency = Metrics::registry().histogram("solicare_decode_seconds", "JPEG decode time");
+// frames.add();
+// { Metrics::ScopedTimer timer(latency); decode(); }
+// Metrics::registry().gauge("solicare_queue_depth", "Queued items", [] { return queue.size(); });
+// std::string text = Metrics::registry().render(); // Prometheus text exposition format
+//
+// Counters and histograms are sharded by thread: every thread updates its own cache line with a relaxed atomic add,
+// so recording costs a few nanoseconds and never takes a lock. Shards are only summed up by render().
+// Registration takes a lock and returns a reference that stays valid for the lifetime of the process,
+// so keep it in a static instead of looking the metric up on the hot path.
+namespace Metrics
+{
+inline constexpr std::size_t SHARD_COUNT      = 16;
+inline constexpr std::size_t MAX_BUCKET_COUNT = 16; // Extra bounds are ignored
+inline constexpr std::size_t CACHE_LINE_SIZE  = 64;
+inline const std::vector<double> LATENCY_BUCKETS = {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05,
+                                                    0.1,    0.25,  0.5,    1.0,   2.5,  5.0,   10.0};
+
+// Threads are spread over the shards round-robin, more threads than shards share them (still lock-free)
+inline std::size_t shard_index()
+{
+	static std::atomic_size_t next_shard = 0;
+	thread_local const std::size_t index = next_shard.fetch_add(1, std::memory_order_relaxed) % SHARD_COUNT;
+	return index;
+}
+
+class Counter
+{
+  public:
+	void add(const std::uint64_t n = 1)
+	{
+		shards_[shard_index()].value.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] std::uint64_t value() const
+	{
+		std::uint64_t total = 0;
+		for (const auto& shard : shards_)
+			total += shard.value.load(std::memory_order_relaxed);
+		return total;
+	}
+
+  private:
+	struct alignas(CACHE_LINE_SIZE) Shard
+	{
+		std::atomic<std::uint64_t> value = 0;
+	};
+	std::array<Shard, SHARD_COUNT> shards_{};
+};
+
+class Histogram
+{
+  public:
+	struct Snapshot
+	{
+		std::vector<double> bounds;
+		std::vector<std::uint64_t> cumulative_counts; // bounds.size() + 1 entries, the last one is +Inf
+		double sum;
+	};
+
+	explicit Histogram(const std::vector<double>& bounds)
+	    : bounds_(bounds.begin(),
+	              bounds.begin() + static_cast<std::ptrdiff_t>(std::min(bounds.size(), MAX_BUCKET_COUNT)))
+	{
+	}
+
+	void observe(const double value)
+	{
+		const auto bucket = static_cast<std::size_t>(std::lower_bound(bounds_.begin(), bounds_.end(), value) -
+		                                             bounds_.begin());
+		const auto nanos  = static_cast<std::uint64_t>(std::max(0.0, value) * 1e9);
+		auto& shard       = shards_[shard_index()];
+		shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+		shard.sum_nanos.fetch_add(nanos, std::memory_order_relaxed);
+	}
+
+	void observe(const std::chrono::steady_clock::duration elapsed)
+	{
+		observe(std::chrono::duration<double>(elapsed).count());
+	}
+
+	[[nodiscard]] Snapshot snapshot() const
+	{
+		Snapshot snapshot{bounds_, std::vector<std::uint64_t>(bounds_.size() + 1, 0), 0.0};
+		std::uint64_t sum_nanos = 0;
+		for (const auto& shard : shards_)
+		{
+			for (std::size_t i = 0; i <= bounds_.size(); ++i)
+				snapshot.cumulative_counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+			sum_nanos += shard.sum_nanos.load(std::memory_order_relaxed);
+		}
+		for (std::size_t i = 1; i < snapshot.cumulative_counts.size(); ++i)
+			snapshot.cumulative_counts[i] += snapshot.cumulative_counts[i - 1];
+		snapshot.sum = static_cast<double>(sum_nanos) / 1e9;
+		return snapshot;
+	}
+
+  private:
+	struct alignas(CACHE_LINE_SIZE) Shard
+	{
+		std::array<std::atomic<std::uint64_t>, MAX_BUCKET_COUNT + 1> counts{};
+		std::atomic<std::uint64_t> sum_nanos = 0;
+	};
+
+	const std::vector<double> bounds_; // Upper bounds in seconds, ascending
+	std::array<Shard, SHARD_COUNT> shards_{};
+};
+
+// Observes the lifetime of the scope into a histogram
+class ScopedTimer
+{
+  public:
+	explicit ScopedTimer(Histogram& histogram) : histogram_(histogram), started_(std::chrono::steady_clock::now())
+	{
+	}
+	~ScopedTimer()
+	{
+		histogram_.observe(std::chrono::steady_clock::now() - started_);
+	}
+
+	ScopedTimer(const ScopedTimer&)            = delete;
+	ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+  private:
+	Histogram& histogram_;
+	const std::chrono::steady_clock::time_point started_;
+};
+
+class Registry
+{
+  public:
+	using Collector = std::function<void(std::string& out)>; // Appends complete exposition lines
+
+	Counter& counter(const std::string& name, const std::string& help, const std::string& labels = {})
+	{
+		std::lock_guard lock(mutex_);
+		auto& family = family_of(name, help, "counter");
+		auto& metric = family.counters[labels];
+		if (!metric)
+			metric = std::make_unique<Counter>();
+		return *metric;
+	}
+
+	Histogram& histogram(const std::string& name, const std::string& help, const std::string& labels = {},
+	                     const std::vector<double>& bounds = LATENCY_BUCKETS)
+	{
+		std::lock_guard lock(mutex_);
+		auto& family = family_of(name, help, "histogram");
+		auto& metric = family.histograms[labels];
+		if (!metric)
+			metric = std::make_unique<Histogram>(bounds);
+		return *metric;
+	}
+
+	// Sampled on every render(), e.g. queue depths; registering the same name and labels again replaces it
+	void gauge(const std::string& name, const std::string& help, std::function<double()> sample,
+	           const std::string& labels = {})
+	{
+		std::lock_guard lock(mutex_);
+		family_of(name, help, "gauge").gauges[labels] = std::move(sample);
+	}
+
+	// Like gauge(), for monotonic values that are already counted elsewhere
+	void sampled_counter(const std::string& name, const std::string& help, std::function<double()> sample,
+	                     const std::string& labels = {})
+	{
+		std::lock_guard lock(mutex_);
+		family_of(name, help, "counter").gauges[labels] = std::move(sample);
+	}
+
+	// For series whose label sets come and go, e.g. one per connected device
+	void collector(Collector collect)
+	{
+		std::lock_guard lock(mutex_);
+		collectors_.push_back(std::move(collect));
+	}
+
+	[[nodiscard]] std::string render() const
+	{
+		std::string out;
+		std::lock_guard lock(mutex_);
+		for (const auto& [name, family] : families_)
+		{
+			out += fmt::format("# HELP {} {}\n# TYPE {} {}\n", name, family.help, name, family.type);
+			for (const auto& [labels, counter] : family.counters)
+				out += fmt::format("{}{} {}\n", name, braced(labels), counter->value());
+			for (const auto& [labels, sample] : family.gauges)
+				out += fmt::format("{}{} {}\n", name, braced(labels), sample());
+			for (const auto& [labels, histogram] : family.histograms)
+			{
+				const auto [bounds, counts, sum] = histogram->snapshot();
+				const auto prefix                = labels.empty() ? std::string() : labels + ",";
+				for (std::size_t i = 0; i < bounds.size(); ++i)
+					out += fmt::format("{}_bucket{{{}le=\"{}\"}} {}\n", name, prefix, bounds[i], counts[i]);
+				out += fmt::format("{}_bucket{{{}le=\"+Inf\"}} {}\n", name, prefix, counts.back());
+				out += fmt::format("{}_sum{} {}\n{}_count{} {}\n", name, braced(labels), sum, name, braced(labels),
+				                   counts.back());
+			}
+		}
+		for (const auto& collect : collectors_)
+			collect(out);
+		return out;
+	}
+
+  private:
+	struct Family
+	{
+		std::string help;
+		std::string type;
+		std::map<std::string, std::unique_ptr<Counter>> counters;
+		std::map<std::string, std::unique_ptr<Histogram>> histograms;
+		std::map<std::string, std::function<double()>> gauges; // Sampled, gauges and sampled counters
+	};
+
+	Family& family_of(const std::string& name, const std::string& help, const std::string& type)
+	{
+		auto& family = families_[name];
+		if (family.type.empty())
+		{
+			family.help = help;
+			family.type = type;
+		}
+		return family;
+	}
+
+	static std::string braced(const std::string& labels)
+	{
+		return labels.empty() ? std::string() : "{" + labels + "}";
+	}
+
+	mutable std::mutex mutex_;
+	std::map<std::string, Family> families_;
+	std::vector<Collector> collectors_;
+};
+
+inline Registry& registry()
+{
+	static Registry instance;
+	return instance;
+}
+} // namespace Metrics
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct DisplayConfig
+{
+	bool enabled          = true;  // false: headless, no HighGUI call at all
+	double max_fps        = 15.0;  // Refresh rate cap of the windows
+	bool mosaic           = false; // Every camera as a tile of one window instead of a window per camera
+	int mosaic_tile_width = 480;   // Tile height follows at 16:9
+};
+
+// Usage Example:
+// DisplayCompositor compositor(config);                   // Starts the display thread
+// compositor.publish("CAM(10.0.0.7)", frame, [=](cv::Mat& image) { /* draw annotations */ });
+// compositor.close("CAM(10.0.0.7)");                     // The camera disconnected, its window goes away
+// compositor.close_all();                                 // Closes the windows, they reopen with the next frame
+//
+// Owns every HighGUI call of the process on one thread. Producers publish the latest frame of each window without
+// waiting for the GUI; the thread redraws at most max_fps times per second from the newest frame of every window and
+// pumps GUI events on every refresh while a window is open, new frame or not. A frame replaced before it was shown
+// is never annotated: its overlay runs on the display thread just before the frame is drawn.
+class DisplayCompositor
+{
+  public:
+	using Overlay = std::function<void(cv::Mat& image)>; // Draws onto the frame about to be shown
+
+	explicit DisplayCompositor(const DisplayConfig& config);
+	~DisplayCompositor(); // Stops the thread and closes the windows
+
+	DisplayCompositor(const DisplayCompositor&)            = delete;
+	DisplayCompositor& operator=(const DisplayCompositor&) = delete;
+
+	// Copies frame into the window's slot, a frame not shown yet is replaced. Any thread, one at a time per window.
+	void publish(const std::string& window, const cv::Mat& frame, Overlay overlay);
+	// Destroys the window at the next refresh, a later publish() reopens it. Any thread.
+	void close(const std::string& window);
+	void close_all();
+
+	[[nodiscard]] std::uint64_t shown() const { return shown_.load(std::memory_order_relaxed); }
+	[[nodiscard]] std::uint64_t replaced() const { return replaced_.load(std::memory_order_relaxed); }
+
+  private:
+	struct Slot
+	{
+		cv::Mat frame; // Latest published frame, swapped with the display thread's copy
+		cv::Mat spare; // Buffer the next publish() copies into outside the lock
+		Overlay overlay;
+		bool fresh = false;
+	};
+
+	void run();
+	void compose_mosaic();
+
+	const DisplayConfig config_;
+
+	std::mutex mutex_;
+	std::condition_variable stopped_;
+	std::map<std::string, Slot> slots_; // By window name, sorted so mosaic tiles keep their place
+	std::vector<std::string> closed_;   // Windows to destroy at the next refresh
+	bool closing_  = false;
+	bool stopping_ = false;
+
+	// Display thread only
+	std::map<std::string, cv::Mat> shown_frames_;
+	cv::Mat mosaic_;
+
+	std::atomic_uint64_t shown_    = 0;
+	std::atomic_uint64_t replaced_ = 0;
+	std::thread thread_;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <string_view>
+
+#include "keypoint_history.hpp"
+#include "pose_model.hpp"
+
+// Posture of the tracked person as judged over time by FallDetector
+enum BODY_POSTURE
+{
+	POSTURE_UNKNOWN,  // No person seen recently, or too few keypoints to judge
+	POSTURE_STANDING,
+	POSTURE_SITTING,
+	POSTURE_LYING,    // Lying down without a preceding fall, e.g. going to bed
+	POSTURE_FALLEN    // A fast descent followed by sustained lying
+};
+
+// Thresholds of FallDetector. Lengths are in torso lengths (shoulder centre to hip centre) so they do not depend on
+// the camera's distance or resolution, angles in degrees from vertical.
+struct FallDetectorConfig
+{
+	double window_seconds     = 0.4;  // Newest part of the keypoint history the features are computed over
+	double descent_speed      = 1.5;  // Downward body centre speed of a fall, torso lengths per second
+	double descent_to_lying   = 1.5;  // Seconds a descent may precede the first lying frame and still count
+	double sustained_lying    = 2.0;  // Seconds of lying after a descent before the person is FALLEN
+	double recovery           = 1.0;  // Seconds upright (standing or sitting) that clear FALLEN
+	double lost_timeout       = 5.0;  // Seconds without the person before a state other than FALLEN is forgotten
+	double lying_angle        = 60.0; // Torso angle above which the person lies
+	double upright_angle      = 35.0; // Torso angle below which the person is upright
+	double lying_aspect_ratio = 1.3;  // Box width / height above which the person lies
+	double sitting_thigh_drop = 0.5;  // Hip-to-knee height below which an upright person sits
+};
+
+// Usage Example:
+// FallDetector detector;                                  // One per camera, next to its KeypointHistory
+// history.push(person, timestamp);
+// detector.update(history.window());                      // Every frame with a detected person
+// detector.update_missing(timestamp);                     // Every frame without one
+// if (detector.posture() == POSTURE_FALLEN) { /* alert */ }
+//
+// Posture classifier over the followed person's keypoint history. Each frame the body centre's vertical velocity
+// (the least-squares slope of its height), the mean torso angle and the mean box aspect ratio are computed over the
+// samples of the last window_seconds; a per-frame posture is derived from them and fed to a state machine that only
+// reports FALLEN when lying follows a fast descent and persists, so lying down slowly or a single noisy frame never
+// raise an alert. window_seconds has to fit in the history at the camera's frame rate, 0.4 s is 6 frames at 15 fps.
+class FallDetector
+{
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	explicit FallDetector(const FallDetectorConfig& config = {}) : config_(config) {}
+
+	void update(const KeypointWindow& window); // Newest sample: the person in the current frame
+	void update_missing(Clock::time_point timestamp);
+	void reset();
+
+	[[nodiscard]] BODY_POSTURE posture() const { return posture_; }
+	[[nodiscard]] double vertical_speed() const { return vertical_speed_; } // Torso lengths per second, down > 0
+	[[nodiscard]] double torso_angle() const { return torso_angle_; }       // Degrees from vertical
+	[[nodiscard]] double aspect_ratio() const { return aspect_ratio_; }     // Box width / height
+
+  private:
+	[[nodiscard]] BODY_POSTURE instant_posture(const KeypointWindow& window, std::size_t sample, float hip_y) const;
+	[[nodiscard]] double seconds_since(Clock::time_point since, Clock::time_point now) const;
+
+	FallDetectorConfig config_;
+	BODY_POSTURE posture_ = POSTURE_UNKNOWN;
+
+	// Features of the last sample, valid once has_sample_ is set
+	bool has_sample_       = false;
+	Clock::time_point last_sample_;
+	double torso_length_   = 0.0; // Upright torso length, frame pixels, the scale of the speed
+	double vertical_speed_ = 0.0;
+	double torso_angle_    = 0.0;
+	double aspect_ratio_   = 0.0;
+
+	// State machine timestamps, default constructed when not set
+	Clock::time_point last_descent_;   // Last frame moving down at descent_speed
+	Clock::time_point lying_since_;    // First frame of the current lying streak
+	bool lying_after_descent_ = false; // The current lying streak started shortly after a descent
+	Clock::time_point upright_since_;  // First frame of the current upright streak
+};
+
+[[nodiscard]] std::string_view to_string(BODY_POSTURE posture); // "unknown", "standing", ...
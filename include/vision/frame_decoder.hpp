@@ -0,0 +1,85 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include <optional>
+#include <utility>
+
+// Usage Example:
+// const auto size = FrameDecoder::jpeg_size(bytes, length); // 1920x1080, read from the header only
+// const int flags = size ? FrameDecoder::reduced_decode_flag(*size, 640) : cv::IMREAD_COLOR; // REDUCED_COLOR_2
+// cv::imdecode(cv::Mat(1, length, CV_8U, bytes), flags, &decoded); // 960x540, reuses decoded's memory
+//
+// libjpeg can decode a JPEG at 1/2, 1/4 or 1/8 of its size by skipping the high DCT coefficients, which is several
+// times cheaper than a full decode followed by a resize. The model only needs its input size, so frames are decoded
+// at the smallest scale whose longer side still covers it; nothing is ever upscaled that a full decode would not.
+namespace FrameDecoder
+{
+// Width and height from the first SOF segment, nullopt if the data is not a well-formed JPEG header
+inline std::optional<cv::Size> jpeg_size(const std::uint8_t* data, const std::size_t size)
+{
+	if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+		return std::nullopt;
+
+	std::size_t offset = 2;
+	while (offset + 4 <= size)
+	{
+		if (data[offset] != 0xFF)
+			return std::nullopt;
+		const std::uint8_t marker = data[offset + 1];
+		if (marker == 0xFF) // Fill byte
+		{
+			++offset;
+			continue;
+		}
+		if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) // Markers without a length
+		{
+			offset += 2;
+			continue;
+		}
+		const std::size_t length = static_cast<std::size_t>(data[offset + 2]) << 8 | data[offset + 3];
+		// SOF0-SOF15, except DHT (C4), JPG (C8) and DAC (CC): [length(2)] [precision(1)] [height(2)] [width(2)]
+		const bool start_of_frame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 &&
+		                            marker != 0xCC;
+		if (start_of_frame)
+		{
+			if (offset + 9 > size)
+				return std::nullopt;
+			const int height = data[offset + 5] << 8 | data[offset + 6];
+			const int width  = data[offset + 7] << 8 | data[offset + 8];
+			if (width == 0 || height == 0)
+				return std::nullopt;
+			return cv::Size(width, height);
+		}
+		if (marker == 0xDA || length < 2) // Start of scan before any SOF
+			return std::nullopt;
+		offset += 2 + length;
+	}
+	return std::nullopt;
+}
+
+// IMREAD_ flag of the smallest DCT-scaled decode whose longer side is still at least target
+inline int reduced_decode_flag(const cv::Size frame, const int target)
+{
+	constexpr std::pair<int, int> REDUCED_DECODES[] = {
+	    {8, cv::IMREAD_REDUCED_COLOR_8}, {4, cv::IMREAD_REDUCED_COLOR_4}, {2, cv::IMREAD_REDUCED_COLOR_2}};
+	const int longer_side = std::max(frame.width, frame.height);
+	for (const auto& [factor, flag] : REDUCED_DECODES)
+	{
+		if ((longer_side + factor - 1) / factor >= target)
+			return flag;
+	}
+	return cv::IMREAD_COLOR;
+}
+
+// Size of a frame decoded with flag, libjpeg rounds a scaled dimension up
+inline cv::Size reduced_size(const cv::Size frame, const int flag)
+{
+	const int factor = flag == cv::IMREAD_REDUCED_COLOR_8 ? 8
+	                   : flag == cv::IMREAD_REDUCED_COLOR_4 ? 4
+	                   : flag == cv::IMREAD_REDUCED_COLOR_2 ? 2
+	                                                        : 1;
+	return {(frame.width + factor - 1) / factor, (frame.height + factor - 1) / factor};
+}
+} // namespace FrameDecoder
@@ -0,0 +1,56 @@
+#pragma once
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <optional>
+
+#include "pose_model.hpp"
+
+struct InferenceRegionConfig
+{
+	bool enabled            = true;
+	int input_size          = 320;   // Model input of a crop, a multiple of 32; needs a dynamic-shape model export
+	float padding           = 0.25f; // Margin around the last box on every side, in box sizes
+	int full_frame_interval = 10;    // Every n-th detection runs on the full frame, so a second person is found
+};
+
+// Usage Example:
+// InferenceRegion region;                                 // One per camera
+// if (region.following()) { /* decode at full resolution */ }
+// if (const auto crop = region.next(frame.size()))        // Before preprocessing, any thread
+//     Preprocess::letterbox_to_blob(frame(*crop), blob, region.config().input_size);
+// region.update(&person);                                 // After each detected or tracked frame, nullptr: lost
+//
+// Chooses the part of the frame the pose model is run on. Once a person is found, a square around their last box
+// is cropped and run at a smaller input, e.g. 320x320 for a quarter of the FLOPs of 640x640. A crop is only taken
+// while it keeps at least the resolution the full frame would get, and it is cut from a full-resolution decode
+// while following() rather than from the reduced one the rest of the frame uses, so small or distant subjects gain
+// keypoint detail and none lose any. Losing the person, and every full_frame_interval-th detection, fall back to the
+// full frame.
+class InferenceRegion
+{
+  public:
+	explicit InferenceRegion(const InferenceRegionConfig& config = {}) : config_(config) {}
+
+	void configure(const InferenceRegionConfig& config); // Before the first frame
+	[[nodiscard]] const InferenceRegionConfig& config() const { return config_; }
+
+	// Crop of the next detection in frame pixels, nullopt to run on the full frame
+	std::optional<cv::Rect> next(cv::Size frame);
+	[[nodiscard]] bool following() const; // A person is followed, the next detections will likely be crops
+	void update(const PoseModel::PoseDetection* person); // Latest position of the followed person, nullptr: lost
+
+  private:
+	InferenceRegionConfig config_;
+
+	mutable std::mutex mutex_;
+	std::optional<cv::Rect2f> box_; // Last box of the followed person
+	int detections_ = 0;            // Detections since the last full frame one
+};
+
+// Letterbox of a crop's model input mapped back to the full frame, so decoded keypoints land in frame pixels
+[[nodiscard]] inline PoseModel::Letterbox offset_letterbox(PoseModel::Letterbox letterbox, const cv::Point origin)
+{
+	letterbox.pad_x -= static_cast<float>(origin.x) * letterbox.scale;
+	letterbox.pad_y -= static_cast<float>(origin.y) * letterbox.scale;
+	return letterbox;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <span>
+
+#include "pose_model.hpp"
+
+// View of the newest samples of a KeypointHistory, oldest first. Invalidated by the next push() or clear().
+// Independent of the history's capacity, so consumers such as FallDetector take any history.
+class KeypointWindow
+{
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	[[nodiscard]] std::size_t size() const { return size_; }
+	[[nodiscard]] bool empty() const { return size_ == 0; }
+
+	[[nodiscard]] std::span<const float> x(const int joint) const { return {x_ + joint * stride_, size_}; }
+	[[nodiscard]] std::span<const float> y(const int joint) const { return {y_ + joint * stride_, size_}; }
+	[[nodiscard]] std::span<const float> confidence(const int joint) const
+	{
+		return {confidence_ + joint * stride_, size_};
+	}
+	[[nodiscard]] std::span<const float> width() const { return {width_, size_}; }   // Box width, frame pixels
+	[[nodiscard]] std::span<const float> height() const { return {height_, size_}; } // Box height, frame pixels
+	[[nodiscard]] std::span<const Clock::time_point> timestamps() const { return {timestamps_, size_}; }
+
+  private:
+	template <std::size_t Capacity>
+	friend class KeypointHistory;
+
+	const float* x_                      = nullptr; // Oldest sample of joint 0, of joint j at j * stride_
+	const float* y_                      = nullptr;
+	const float* confidence_             = nullptr;
+	const float* width_                  = nullptr;
+	const float* height_                 = nullptr;
+	const Clock::time_point* timestamps_ = nullptr;
+	std::size_t stride_                  = 0;
+	std::size_t size_                    = 0;
+};
+
+// Usage Example:
+// KeypointHistory<30> history;
+// history.push(person, steady_clock::now());          // O(1), no allocation
+// const auto window = history.window(10);              // Last 10 frames, oldest first
+// const auto hip_y  = window.y(PoseModel::LEFT_HIP);   // std::span<const float> of 10 contiguous values
+//
+// Fixed-capacity history of one person's keypoints, stored structure-of-arrays: every joint has its own x, y and
+// confidence series over time, so a temporal feature of one joint is a loop over contiguous floats that the compiler
+// can vectorize. Each sample is written twice, at its ring position and one capacity further, so the newest n samples
+// are always contiguous and a window never wraps around.
+template <std::size_t Capacity>
+class KeypointHistory
+{
+	static_assert(Capacity > 0);
+
+	static constexpr std::size_t STRIDE = 2 * Capacity; // Values of one series, mirrored
+
+  public:
+	using Clock  = KeypointWindow::Clock;
+	using Window = KeypointWindow;
+
+	static constexpr std::size_t capacity() { return Capacity; }
+	[[nodiscard]] std::size_t size() const { return size_; }
+	[[nodiscard]] bool empty() const { return size_ == 0; }
+	[[nodiscard]] bool full() const { return size_ == Capacity; }
+
+	// Appends a frame, the oldest one is overwritten once the history is full
+	void push(const PoseModel::PoseDetection& person, const Clock::time_point timestamp)
+	{
+		const std::size_t mirror = next_ + Capacity;
+		for (int joint = 0; joint < PoseModel::KEYPOINT_COUNT; ++joint)
+		{
+			const std::size_t series = joint * STRIDE;
+			x_[series + next_] = x_[series + mirror] = person.keypoints[joint].x;
+			y_[series + next_] = y_[series + mirror] = person.keypoints[joint].y;
+			confidence_[series + next_] = confidence_[series + mirror] = person.confidence[joint];
+		}
+		width_[next_] = width_[mirror] = person.box.width;
+		height_[next_] = height_[mirror] = person.box.height;
+		timestamps_[next_] = timestamps_[mirror] = timestamp;
+
+		next_ = next_ + 1 == Capacity ? 0 : next_ + 1;
+		if (size_ < Capacity)
+			++size_;
+	}
+
+	void clear()
+	{
+		next_ = 0;
+		size_ = 0;
+	}
+
+	// Newest min(frames, size()) samples
+	[[nodiscard]] Window window(std::size_t frames = Capacity) const
+	{
+		frames = std::min(frames, size_);
+		// The newest sample is at next_ - 1, its mirror at next_ - 1 + Capacity
+		const std::size_t start = (next_ >= frames ? next_ : next_ + Capacity) - frames;
+		Window window;
+		window.x_          = x_.data() + start;
+		window.y_          = y_.data() + start;
+		window.confidence_ = confidence_.data() + start;
+		window.width_      = width_.data() + start;
+		window.height_     = height_.data() + start;
+		window.timestamps_ = timestamps_.data() + start;
+		window.stride_     = STRIDE;
+		window.size_       = frames;
+		return window;
+	}
+
+	[[nodiscard]] Clock::time_point newest_timestamp() const
+	{
+		return timestamps_[next_ == 0 ? Capacity - 1 : next_ - 1];
+	}
+
+  private:
+	std::array<float, PoseModel::KEYPOINT_COUNT * STRIDE> x_{}; // Series of joint j at j * STRIDE
+	std::array<float, PoseModel::KEYPOINT_COUNT * STRIDE> y_{};
+	std::array<float, PoseModel::KEYPOINT_COUNT * STRIDE> confidence_{};
+	std::array<float, STRIDE> width_{};
+	std::array<float, STRIDE> height_{};
+	std::array<Clock::time_point, STRIDE> timestamps_{};
+	std::size_t next_ = 0; // Ring position of the next sample
+	std::size_t size_ = 0;
+};
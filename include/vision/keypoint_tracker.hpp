@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include <optional>
+
+#include "pose_model.hpp"
+
+struct KeypointTrackerConfig
+{
+	bool enabled        = true;
+	int min_interval    = 1;     // Fewest frames between two detector runs, at fast motion
+	int max_interval    = 6;     // Most frames between two detector runs, at slow motion
+	double still_motion = 0.005; // Keypoint motion per frame, in box heights, up to which max_interval applies
+	double fast_motion  = 0.04;  // Keypoint motion per frame from which min_interval applies
+	// Busy fraction of the inference thread above which the interval is stretched, up to max_interval
+	double busy_utilization = 0.6;
+	double min_confidence   = 0.6;  // Fraction of keypoints still followed below which the detector runs again
+	float max_round_trip    = 2.0f; // Forward-backward flow error in pixels above which a keypoint is lost
+	int window              = 21;   // Optical flow search window in pixels, per pyramid level
+	int pyramid_levels      = 2;
+};
+
+// Usage Example:
+// KeypointTracker tracker;                                // One per camera
+// if (tracker.needs_detection(utilization))               // Gate stage, any thread
+//     tracker.detected(&person, gray);                    // Serial: detector result of the frame
+// else
+//     auto person = tracker.track(gray);                  // Serial: keypoints moved to the frame, ~0.2 ms
+//
+// Runs the pose detector only every few frames and follows the person in between with pyramidal Lucas-Kanade flow
+// of the confident keypoints alone, a forward-backward check drops keypoints that lost their texture. The interval
+// adapts to the measured keypoint motion and, under load, to the busy fraction of the inference thread; the detector
+// runs early whenever too few keypoints are still followed, so a fast fall is never tracked on stale keypoints.
+// needs_detection() may be called from several threads, the others in frame order from one thread at a time.
+class KeypointTracker
+{
+  public:
+	explicit KeypointTracker(const KeypointTrackerConfig& config = {}) : config_(config) {}
+
+	void configure(const KeypointTrackerConfig& config); // Before the first frame
+	[[nodiscard]] const KeypointTrackerConfig& config() const { return config_; }
+
+	// Whether the frame has to go through the detector, utilization is the busy fraction of the inference thread
+	bool needs_detection(double utilization);
+
+	// Detector result of a frame, nullptr when nobody was found. gray: the frame as 8-bit grayscale.
+	void detected(const PoseModel::PoseDetection* person, const cv::Mat& gray);
+	// Detector result of a frame that finished after later frames were tracked, carried forward to the newest one
+	void detected_late(const PoseModel::PoseDetection& person, const cv::Mat& gray);
+	// The followed person moved to a frame that skipped the detector, nullopt once the track is lost
+	std::optional<PoseModel::PoseDetection> track(const cv::Mat& gray);
+
+	[[nodiscard]] int interval(double utilization) const; // Frames between detector runs at the current motion
+	[[nodiscard]] double confidence() const { return confidence_.load(std::memory_order_relaxed); }
+	[[nodiscard]] double motion() const { return motion_.load(std::memory_order_relaxed); } // Box heights / frame
+	[[nodiscard]] std::uint64_t tracked() const { return tracked_.load(std::memory_order_relaxed); }
+
+  private:
+	// Moves the confident keypoints of person from one frame to the other, false when too few could be followed
+	bool propagate(const cv::Mat& from, const cv::Mat& to, PoseModel::PoseDetection& person);
+	void observe_motion(const PoseModel::PoseDetection& before, const PoseModel::PoseDetection& after);
+
+	KeypointTrackerConfig config_;
+
+	// Serial state
+	cv::Mat previous_;                // Grayscale of the last frame detected or tracked
+	PoseModel::PoseDetection person_; // Followed person on previous_
+	int detected_keypoints_ = 0;      // Confident keypoints of the last detection
+
+	// Read by needs_detection()
+	std::atomic_bool following_      = false; // person_ is valid
+	std::atomic<double> confidence_  = 0.0;   // Fraction of the detected keypoints still followed
+	std::atomic<double> motion_      = 0.0;   // Running mean of the keypoint motion, box heights per frame
+	std::atomic_int since_detection_ = 0;     // Frames given to the tracker since the last detector run
+	std::atomic_uint64_t tracked_    = 0;     // Frames that skipped the detector
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+
+struct MotionGateConfig
+{
+	bool enabled            = true;
+	int width               = 160;   // Width of the downscaled grayscale frames that are compared
+	int pixel_threshold     = 20;    // Gray level change of a pixel that counts as motion
+	double motion_threshold = 0.005; // Fraction of changed pixels that runs inference
+	// Longest time between two inferences of a static scene
+	std::chrono::milliseconds heartbeat = std::chrono::seconds(2);
+	// Inference keeps running this long after the last motion, so a person who falls and lies still is followed until
+	// FallDetector has confirmed the fall
+	std::chrono::milliseconds hold = std::chrono::seconds(4);
+};
+
+// Usage Example:
+// MotionGate gate;                                       // One per camera
+// if (gate.evaluate(frame, steady_clock::now()).infer) { /* run the pose model */ }
+// gate.skip_ratio();                                     // 0.9: nine frames out of ten did not need the model
+//
+// Decides per frame whether the pose model has to run. The frame is shrunk to a small grayscale image and compared
+// with the one of the last inference; inference runs when enough pixels changed, while motion was seen recently,
+// or when the heartbeat is due. Comparing against the last inference instead of the previous frame also catches
+// changes too slow to show between two frames. evaluate() may be called from several threads.
+class MotionGate
+{
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Decision
+	{
+		bool infer;    // The frame has to go through the pose model
+		double motion; // Fraction of changed pixels, 1 without a reference frame
+	};
+
+	explicit MotionGate(const MotionGateConfig& config = {}) : config_(config) {}
+
+	void configure(const MotionGateConfig& config); // Before the first evaluate()
+	[[nodiscard]] const MotionGateConfig& config() const { return config_; }
+
+	Decision evaluate(const cv::Mat& frame, Clock::time_point now);
+
+	[[nodiscard]] std::uint64_t evaluated() const { return evaluated_.load(std::memory_order_relaxed); }
+	[[nodiscard]] std::uint64_t skipped() const { return skipped_.load(std::memory_order_relaxed); }
+	[[nodiscard]] double skip_ratio() const;
+
+  private:
+	MotionGateConfig config_;
+
+	std::mutex mutex_;
+	cv::Mat reference_; // Downscaled grayscale frame of the last inference
+	Clock::time_point last_inference_;
+	Clock::time_point last_motion_;
+
+	std::atomic_uint64_t evaluated_ = 0;
+	std::atomic_uint64_t skipped_   = 0;
+};
+
+// Pixels of two equally sized 8-bit images that differ by more than threshold, vectorized with AVX2 or NEON
+[[nodiscard]] std::size_t count_changed_pixels(const std::uint8_t* first, const std::uint8_t* second,
+                                               std::size_t count, int threshold);
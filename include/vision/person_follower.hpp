@@ -0,0 +1,36 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <optional>
+
+#include "pose_decoder.hpp"
+
+struct PersonFollowerConfig
+{
+	float min_iou  = 0.3f; // Overlap with the last box from which a detection is the followed person
+	int max_missed = 3;    // Detections without the followed person before another one is followed
+};
+
+// Usage Example:
+// PersonFollower follower;                                // One per camera
+// const int index = follower.select(people);              // Detected frame: followed person, -1: not in view
+// follower.follow(person);                                // Tracked frame: where the tracker moved them
+//
+// Keeps tracking and fall detection on the same person while several are in view. The followed person is found
+// again in each detection by the overlap with their last box; the most confident detection is only followed
+// instead once they went missing for more than max_missed detections in a row. Called in frame order.
+class PersonFollower
+{
+  public:
+	explicit PersonFollower(const PersonFollowerConfig& config = {}) : config_(config) {}
+
+	int select(const PoseDecoder::PoseDetections& people);
+	[[nodiscard]] int match(const PoseDecoder::PoseDetections& people) const; // Like select(), changes nothing
+	void follow(const PoseModel::PoseDetection& person);
+	[[nodiscard]] bool switched() const { return switched_; } // The last select() started following someone else
+
+  private:
+	PersonFollowerConfig config_;
+	std::optional<cv::Rect2f> box_; // Last box of the followed person
+	int missed_    = 0;             // Detections in a row without them
+	bool switched_ = false;
+};
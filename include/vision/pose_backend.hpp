@@ -0,0 +1,62 @@
+#pragma once
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Inference runtimes the pose model can be run with, see make_pose_backend()
+enum POSE_BACKEND
+{
+	BACKEND_AUTO,        // OpenCV CUDA if a CUDA device is available, OpenCV CPU otherwise
+	BACKEND_OPENCV_CPU,  // OpenCV DNN on the CPU
+	BACKEND_OPENCV_CUDA, // OpenCV DNN on a CUDA device, requires OpenCV built with CUDA
+	BACKEND_OPENVINO,    // OpenCV DNN through OpenVINO, requires OpenCV built with OpenVINO
+	BACKEND_ONNXRUNTIME  // ONNX Runtime CPU provider, requires building with SOLICARE_WITH_ONNXRUNTIME
+};
+
+enum POSE_PRECISION
+{
+	PRECISION_FP32,
+	PRECISION_INT8 // Statically quantized (QDQ) export of the same model
+};
+
+struct PoseBackendConfig
+{
+	POSE_BACKEND backend        = BACKEND_AUTO;
+	POSE_PRECISION precision    = PRECISION_FP32;
+	std::string fp32_model_path = "../models/yolov8n-pose.onnx";
+	std::string int8_model_path = "../models/yolov8n-pose-int8.onnx";
+	int threads                 = 0; // ONNX Runtime intra-op threads, 0: runtime default. OpenCV DNN runs on the
+	                                 // process-wide cv::setNumThreads(), which the application sets once
+
+	[[nodiscard]] const std::string& model_path() const
+	{
+		return precision == PRECISION_INT8 ? int8_model_path : fp32_model_path;
+	}
+};
+
+// Runs the pose model on a preprocessed NCHW float blob ([B, 3, H, W]) and returns its raw [B, 56, anchors] output.
+// The output belongs to the caller and stays valid across later forward() calls. A backend is used by one thread at
+// a time.
+class PoseBackend
+{
+  public:
+	virtual ~PoseBackend() = default;
+
+	[[nodiscard]] virtual std::string name() const = 0; // e.g. "openvino/int8"
+	virtual cv::Mat forward(const cv::Mat& blob)       = 0;
+};
+
+// Loads the configured model into the configured runtime. BACKEND_AUTO has to be resolved by the caller.
+// Throws std::runtime_error if the runtime is not available in this build, cv::Exception if the model fails to load.
+std::unique_ptr<PoseBackend> make_pose_backend(const PoseBackendConfig& config);
+
+[[nodiscard]] bool is_pose_backend_available(POSE_BACKEND backend);
+
+// Names used by configuration and tools: "auto", "opencv", "opencv-cuda", "openvino", "onnxruntime"; "fp32", "int8"
+[[nodiscard]] std::string_view to_string(POSE_BACKEND backend);
+[[nodiscard]] std::string_view to_string(POSE_PRECISION precision);
+[[nodiscard]] std::optional<POSE_BACKEND> parse_pose_backend(std::string_view name);
+[[nodiscard]] std::optional<POSE_PRECISION> parse_pose_precision(std::string_view name);
@@ -0,0 +1,34 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <opencv2/opencv.hpp>
+
+#include "pose_model.hpp"
+
+// Post-processing of the YOLOv8-pose output ([56, anchors] or [1, 56, anchors] float, see PoseModel): every anchor
+// above the score threshold is a candidate, overlapping candidates are suppressed greedily by score (NMS) and the
+// box and 17 keypoints of the kept people are mapped back to frame pixels.
+// The score channel is contiguous, so the threshold scan runs over it with AVX2 or NEON and only the survivors'
+// other channels are read. Candidates are few in practice, decoding a frame takes a few microseconds.
+namespace PoseDecoder
+{
+inline constexpr float IOU_THRESHOLD = 0.45f; // Candidates overlapping a better one by more are duplicates
+inline constexpr int MAX_DETECTIONS  = 8;     // People kept per frame
+inline constexpr int MAX_CANDIDATES  = 256;   // Best scoring anchors considered by NMS
+
+// Kept people, best score first
+struct PoseDetections
+{
+	std::array<PoseModel::PoseDetection, MAX_DETECTIONS> items;
+	int count = 0;
+
+	[[nodiscard]] bool empty() const { return count == 0; }
+	[[nodiscard]] const PoseModel::PoseDetection& front() const { return items[0]; }
+	[[nodiscard]] const PoseModel::PoseDetection* begin() const { return items.data(); }
+	[[nodiscard]] const PoseModel::PoseDetection* end() const { return items.data() + count; }
+};
+
+// Decodes one image's output into detections, an output of an unexpected shape yields no detections
+void decode(const cv::Mat& output, const PoseModel::Letterbox& letterbox, PoseDetections& detections,
+            float score_threshold = PoseModel::SCORE_THRESHOLD, float iou_threshold = IOU_THRESHOLD);
+} // namespace PoseDecoder
@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "pose_backend.hpp"
+
+// Runs the pose model for the frames of every camera in batches on one thread. Requests are collected until
+// max_batch_size of them are waiting or the oldest one has waited for max_batch_delay, then a single forward()
+// serves the whole batch and every request completes with its slice of the output. Only requests of the same input
+// size share a batch. An input size given a backend of its own with add_backend() never reaches the default one, so
+// neither has to reshape or recompile its network when full frames and crops alternate.
+// A failed batch is retried one request at a time. If those succeed, the model most likely has a fixed batch size
+// of 1: the service runs one request per forward() for the next BATCH_RETRY_FRAMES requests, then tries batching
+// again. A batch that fails along with its single requests (a transient backend error) leaves batching on.
+class PoseInferenceService
+{
+  public:
+	struct Result
+	{
+		cv::Mat batch_output; // [B, 56, anchors], shared by the requests of the batch
+		int index = 0;        // Position of the request in the batch
+		std::string error;    // Empty on success
+
+		// [56, anchors] view into batch_output, valid while the result is alive. anchors follows the input size, see
+		// PoseModel::anchor_count(): 8400 for a full frame at 640, 2100 for a crop at 320.
+		[[nodiscard]] cv::Mat output() const;
+	};
+	using Completion = std::function<void(Result)>;
+
+	static constexpr int BATCH_RETRY_FRAMES = 1000;
+
+	PoseInferenceService(PoseBackend& backend, std::size_t max_batch_size, std::chrono::microseconds max_batch_delay);
+	~PoseInferenceService(); // Completes the requests still queued
+
+	PoseInferenceService(const PoseInferenceService&)            = delete;
+	PoseInferenceService& operator=(const PoseInferenceService&) = delete;
+
+	// Runs inputs of input_size x input_size on backend instead of the default one. Before the first submit().
+	void add_backend(int input_size, PoseBackend& backend);
+
+	// tensor: [1, 3, H, W] float model input, see Preprocess::letterbox_to_blob(). It must stay unchanged until the
+	// completion, which runs on the inference thread.
+	void submit(cv::Mat tensor, Completion completion);
+
+	// Running mean of the fraction of time the inference thread spends in forward(), 1 when it never idles
+	[[nodiscard]] double utilization() const { return utilization_.load(std::memory_order_relaxed); }
+
+  private:
+	struct Request
+	{
+		cv::Mat tensor;
+		Completion completion;
+		std::chrono::steady_clock::time_point submitted;
+	};
+
+	void run();
+	cv::Mat pack(const std::vector<Request>& batch); // [B, 3, H, W] input of one forward()
+	bool infer(std::vector<Request>& batch);         // false: forward() failed, the requests completed with the error
+	PoseBackend& backend_for(const cv::Mat& tensor);
+	void record_busy(std::chrono::steady_clock::time_point started, std::chrono::steady_clock::time_point finished);
+
+	PoseBackend& backend_; // Only used by the inference thread
+	std::vector<std::pair<int, PoseBackend*>> sized_backends_; // By input size, only used by the inference thread
+	const std::size_t configured_batch_size_;
+	std::size_t max_batch_size_; // 1 while falling back to single-frame inference
+	int single_frames_left_ = 0; // Inference thread only, single-frame forwards before batching is retried
+	const std::chrono::microseconds max_batch_delay_;
+	cv::Mat batch_tensor_; // [B, 3, H, W], the inputs of a batch packed for one forward(), reused across batches
+	std::chrono::steady_clock::time_point last_finished_; // End of the previous batch, for utilization_
+	std::atomic<double> utilization_ = 0.0;
+
+	std::mutex mutex_;
+	std::condition_variable requested_;
+	std::vector<Request> pending_;
+	bool stopping_ = false;
+	std::thread thread_;
+};
@@ -0,0 +1,122 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <opencv2/opencv.hpp>
+#include <utility>
+
+// Usage Example:
+// cv::Mat input;
+// const auto letterbox = PoseModel::letterbox(frame, input);   // frame -> 640x640 model input
+// ... run the model on input, decode its output with PoseDecoder::decode(output, letterbox, detections) ...
+// for (const auto& person : detections) { person.keypoints[PoseModel::NOSE]; }
+//
+// Shapes and helpers of the YOLOv8-pose model. The model output is [1, 56, 8400]: for each of the 8400 anchors,
+// channels 0-3 hold the box (cx, cy, w, h), channel 4 the person score and channels 5-55 the 17 COCO keypoints
+// as (x, y, confidence), all in model input pixels.
+namespace PoseModel
+{
+inline constexpr int INPUT_SIZE           = 640;
+inline constexpr int KEYPOINT_COUNT       = 17;
+inline constexpr int BOX_CHANNELS         = 5; // cx, cy, w, h, score
+inline constexpr int OUTPUT_CHANNELS      = BOX_CHANNELS + KEYPOINT_COUNT * 3;
+inline constexpr int ANCHOR_COUNT         = 8400; // At INPUT_SIZE
+inline constexpr double PADDING_COLOR     = 114; // Letterbox border used in training
+inline constexpr float SCORE_THRESHOLD    = 0.5f;
+inline constexpr float KEYPOINT_THRESHOLD = 0.3f;
+
+// Anchors of the three detection heads (strides 8, 16 and 32) for a square input, 8400 at 640x640
+constexpr int anchor_count(const int input_size)
+{
+	return (input_size / 8) * (input_size / 8) + (input_size / 16) * (input_size / 16) +
+	       (input_size / 32) * (input_size / 32);
+}
+
+// COCO keypoint order
+enum KEYPOINT
+{
+	NOSE,
+	LEFT_EYE,
+	RIGHT_EYE,
+	LEFT_EAR,
+	RIGHT_EAR,
+	LEFT_SHOULDER,
+	RIGHT_SHOULDER,
+	LEFT_ELBOW,
+	RIGHT_ELBOW,
+	LEFT_WRIST,
+	RIGHT_WRIST,
+	LEFT_HIP,
+	RIGHT_HIP,
+	LEFT_KNEE,
+	RIGHT_KNEE,
+	LEFT_ANKLE,
+	RIGHT_ANKLE
+};
+
+// Limbs drawn between keypoints
+inline constexpr std::array<std::pair<int, int>, 19> SKELETON = {{
+    {LEFT_ANKLE, LEFT_KNEE},         {LEFT_KNEE, LEFT_HIP},           {RIGHT_ANKLE, RIGHT_KNEE},
+    {RIGHT_KNEE, RIGHT_HIP},         {LEFT_HIP, RIGHT_HIP},           {LEFT_SHOULDER, LEFT_HIP},
+    {RIGHT_SHOULDER, RIGHT_HIP},     {LEFT_SHOULDER, RIGHT_SHOULDER}, {LEFT_SHOULDER, LEFT_ELBOW},
+    {RIGHT_SHOULDER, RIGHT_ELBOW},   {LEFT_ELBOW, LEFT_WRIST},        {RIGHT_ELBOW, RIGHT_WRIST},
+    {LEFT_EYE, RIGHT_EYE},           {NOSE, LEFT_EYE},                {NOSE, RIGHT_EYE},
+    {LEFT_EYE, LEFT_EAR},            {RIGHT_EYE, RIGHT_EAR},          {LEFT_EAR, LEFT_SHOULDER},
+    {RIGHT_EAR, RIGHT_SHOULDER}}};
+
+// Placement of a frame inside the square model input: input = frame * scale + pad
+struct Letterbox
+{
+	float scale = 1.0f;
+	float pad_x = 0.0f;
+	float pad_y = 0.0f;
+
+	[[nodiscard]] cv::Point2f to_frame(const float x, const float y) const
+	{
+		return {(x - pad_x) / scale, (y - pad_y) / scale};
+	}
+};
+
+struct PoseDetection
+{
+	cv::Rect2f box; // Frame pixels
+	float score = 0.0f;
+	std::array<cv::Point2f, KEYPOINT_COUNT> keypoints{}; // Frame pixels
+	std::array<float, KEYPOINT_COUNT> confidence{};
+};
+
+// Where a frame lands inside the size x size model input: scaled to fit, centred, content receives the pixels
+inline Letterbox letterbox_placement(const cv::Size frame, const int size, cv::Rect& content)
+{
+	Letterbox placement;
+	placement.scale = std::min(static_cast<float>(size) / static_cast<float>(frame.width),
+	                           static_cast<float>(size) / static_cast<float>(frame.height));
+	content.width   = std::max(1, static_cast<int>(std::round(static_cast<float>(frame.width) * placement.scale)));
+	content.height  = std::max(1, static_cast<int>(std::round(static_cast<float>(frame.height) * placement.scale)));
+	content.x       = (size - content.width) / 2;
+	content.y       = (size - content.height) / 2;
+	placement.pad_x = static_cast<float>(content.x);
+	placement.pad_y = static_cast<float>(content.y);
+	return placement;
+}
+
+// Resizes the frame into a size x size image keeping its aspect ratio, the rest is padded.
+// input is reused when it already has the right size and type: the frame is resized straight into its centre and
+// only the borders are repainted. The camera pipeline uses the fused Preprocess::letterbox_to_tensor() instead.
+inline Letterbox letterbox(const cv::Mat& frame, cv::Mat& input, const int size = INPUT_SIZE)
+{
+	cv::Rect content;
+	const auto placement = letterbox_placement(cv::Size(frame.cols, frame.rows), size, content);
+
+	input.create(size, size, frame.type());
+	const cv::Scalar padding = cv::Scalar::all(PADDING_COLOR);
+	input(cv::Rect(0, 0, size, content.y)).setTo(padding);
+	input(cv::Rect(0, content.y + content.height, size, size - content.height - content.y)).setTo(padding);
+	input(cv::Rect(0, content.y, content.x, content.height)).setTo(padding);
+	input(cv::Rect(content.x + content.width, content.y, size - content.width - content.x, content.height))
+	    .setTo(padding);
+	cv::Mat resized = input(content);
+	cv::resize(frame, resized, content.size(), 0, 0, cv::INTER_LINEAR);
+	return placement;
+}
+} // namespace PoseModel
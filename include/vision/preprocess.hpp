@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include <string_view>
+
+#include "pose_model.hpp"
+
+// Model input preprocessing in a single pass over the frame: bilinear letterbox resize, BGR->RGB swap,
+// u8->f32 normalization to [0, 1] and HWC->CHW layout, written straight into the input tensor. Equivalent to
+// PoseModel::letterbox() + cv::dnn::blobFromImage(input, 1 / 255.0, {}, {}, true, false) without the intermediate
+// images. Vectorized with NEON on AArch64 and with AVX2 on x86-64 CPUs that have it, scalar otherwise.
+namespace Preprocess
+{
+// frame: BGR, 8 bits per channel, rows stride bytes apart. tensor: 3 * size * size floats.
+PoseModel::Letterbox letterbox_to_tensor(const std::uint8_t* frame, int width, int height, std::size_t stride,
+                                         float* tensor, int size = PoseModel::INPUT_SIZE);
+
+// frame: CV_8UC3. blob: [1, 3, size, size] CV_32F, allocated on first use and reused afterwards.
+PoseModel::Letterbox letterbox_to_blob(const cv::Mat& frame, cv::Mat& blob, int size = PoseModel::INPUT_SIZE);
+
+[[nodiscard]] std::string_view instruction_set(); // Kernels this CPU runs: "avx2", "neon" or "scalar"
+} // namespace Preprocess
@@ -11,97 +11,175 @@ namespace
 {
 constexpr std::string_view TAG = "AsyncWebSocketServer";
 constexpr auto CONSOLE_COLOR   = Logger::ConsoleColor::BLUE;
+
+void close_websocket(const shared_ptr<WebSocket>& ws, const string& device_ip)
+{
+	if (!ws->is_open() || !ws->next_layer().is_open())
+		return;
+	ws->async_close(boost::beast::websocket::close_code::normal,
+	                [device_ip](const boost::system::error_code& ec)
+	                {
+		                if (!ec)
+		                {
+			                Logger::info(TAG, CONSOLE_COLOR, "[Close] WebSocket closed for device_ip={}", device_ip);
+		                }
+		                else
+		                {
+			                Logger::error(TAG, "[Close] Error closing WebSocket for device_ip={}: {}", device_ip,
+			                              ec.message());
+		                }
+	                });
+}
+
+// Answers with a bare HTTP status and closes, without ever creating a connection or parsing the request
+void reject_socket(const shared_ptr<Socket>& socket, const boost::beast::http::status status)
+{
+	ws_rejected_connections.fetch_add(1, memory_order_relaxed);
+	const auto reason   = boost::beast::http::obsolete_reason(status);
+	const auto response = make_shared<string>(
+	    fmt::format("HTTP/1.1 {} {}\r\nRetry-After: {}\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+	                static_cast<unsigned>(status), std::string_view(reason.data(), reason.size()),
+	                ws_server_config.admission_retry_after));
+	async_write(*socket, buffer(*response),
+	            [socket, response](const boost::system::error_code&, size_t)
+	            {
+		            boost::system::error_code ec;
+		            socket->shutdown(ip::tcp::socket::shutdown_both, ec);
+		            socket->close(ec);
+	            });
+}
+
+string remote_address(const Socket& socket)
+{
+	boost::system::error_code ec;
+	const auto endpoint = socket.remote_endpoint(ec);
+	return ec ? string("unknown") : endpoint.address().to_string();
+}
+
+string remote_id(const Socket& socket)
+{
+	boost::system::error_code ec;
+	const auto endpoint = socket.remote_endpoint(ec);
+	return ec ? string("unknown") : fmt::format("{}:{}", endpoint.address().to_string(), endpoint.port());
+}
 } // namespace
 
 // Initialize static members
 bool WebSocketServerContext::flag_stop_server = false;
 SessionMap WebSocketServerContext::ws_session_map;
 ServerConfig WebSocketServerContext::ws_server_config;
-TimePoint WebSocketServerContext::ws_last_session_logged;
+atomic<shared_ptr<BufferPool>> WebSocketServerContext::ws_buffer_pool;
+atomic<uint64_t> WebSocketServerContext::ws_rejected_connections = 0;
 
-AsyncWebSocketServer::AsyncWebSocketServer(io_context& io_context)
-    : socket_acceptor_(make_shared<AsyncSocketAcceptor>(io_context))
+AsyncWebSocketServer::AsyncWebSocketServer(io_context& io_context, IoContextPool& io_context_pool)
+    : connection_registry_(make_shared<AsyncConnectionRegistry>()),
+      buffer_pool_(
+          make_shared<BufferPool>(ws_server_config.buffer_pool_size, ws_server_config.max_pooled_buffer_bytes)),
+      socket_acceptor_(
+          make_shared<AsyncSocketAcceptor>(io_context, io_context_pool, connection_registry_, buffer_pool_)),
+      session_log_timer_(io_context)
 {
+	// Connections of a previous server keep its pool, only the stats readers move over to this one
+	ws_buffer_pool.store(buffer_pool_);
 }
 
 void AsyncWebSocketServer::start()
 {
 	socket_acceptor_->do_accept();
-	periodic_session_manage_thread_ = make_shared<jthread>(
-	    [](const stop_token& st)
-	    {
-		    ws_last_session_logged = steady_clock::now();
-		    while (!st.stop_requested())
-		    {
-			    on_session_manage();
-			    this_thread::sleep_for(milliseconds(ws_server_config.session_manage_period_ms));
-		    }
-	    });
-	Logger::log_info(
-	    TAG,
-	    fmt::format("Server started successfully on port {}", socket_acceptor_->acceptor_->local_endpoint().port()),
-	    CONSOLE_COLOR);
+	schedule_session_manage();
+	Logger::info(TAG, CONSOLE_COLOR, "Server started successfully on port {}",
+	             socket_acceptor_->acceptor_->local_endpoint().port());
 }
 
 void AsyncWebSocketServer::stop()
+{
+	async_stop(milliseconds(ws_server_config.shutdown_grace_period)).wait();
+}
+
+future<void> AsyncWebSocketServer::async_stop(const milliseconds grace_period, function<void()> on_stopped)
 {
 	flag_stop_server = true;
-	if (periodic_session_manage_thread_)
-	{
-		periodic_session_manage_thread_->request_stop();
-	}
-	if (socket_acceptor_ && socket_acceptor_->acceptor_ && socket_acceptor_->acceptor_->is_open())
+
+	// The acceptor and the log timer belong to the acceptor's io_context
+	post(socket_acceptor_->io_context_,
+	     [self = shared_from_this()]()
+	     {
+		     self->session_log_timer_.cancel();
+		     if (self->socket_acceptor_->acceptor_ && self->socket_acceptor_->acceptor_->is_open())
+		     {
+			     boost::system::error_code ec;
+			     self->socket_acceptor_->acceptor_->close(ec);
+		     }
+	     });
+
+	const auto connections = connection_registry_->snapshot();
+	for (const auto& connection : connections)
 	{
-		socket_acceptor_->acceptor_->close();
+		connection->close();
 	}
-	ws_session_map.cvisit_all(
-	    [&](const auto& pair)
+
+	const auto deadline = make_shared<steady_timer>(socket_acceptor_->io_context_, grace_period);
+	deadline->async_wait(
+	    [deadline, registry = connection_registry_](const boost::system::error_code& ec)
 	    {
-		    const auto& session = pair.second;
-		    if (session && session->ws && session->ws->is_open() && session->ws->next_layer().is_open())
+		    if (ec)
+			    return;
+		    const auto stragglers = registry->snapshot();
+		    if (!stragglers.empty())
 		    {
-			    const auto device_ip = session->ws->next_layer().remote_endpoint().address().to_string();
-			    session->ws->async_close(
-			        boost::beast::websocket::close_code::normal,
-			        [device_ip](const boost::system::error_code& ec)
-			        {
-				        if (!ec)
-				        {
-					        Logger::log_info(TAG, fmt::format("[Close] WebSocket closed for device_ip={}", device_ip),
-					                         CONSOLE_COLOR);
-				        }
-				        else
-				        {
-					        Logger::log_error(TAG, fmt::format("[Close] Error closing WebSocket for device_ip={}: {}",
-					                                           device_ip, ec.message()));
-				        }
-			        });
+			    Logger::warn(TAG, "[Stop] Force-closing {} connection(s) that did not close in time.",
+			                 stragglers.size());
 		    }
-	    });
-	ws_session_map.cvisit_all(
-	    [&](const auto& pair)
-	    {
-		    const auto& session = pair.second;
-		    while (session && session->ws && session->ws->is_open() && session->ws->next_layer().is_open())
+		    for (const auto& connection : stragglers)
 		    {
-			    std::this_thread::sleep_for(milliseconds(10));
+			    connection->force_close();
 		    }
 	    });
-	std::this_thread::sleep_for(milliseconds(1000));
-	Logger::log_info(
-	    TAG, fmt::format("WebSocket server on port {} has been stopped successfully.", ws_server_config.server_port),
-	    CONSOLE_COLOR);
+
+	const auto promise = make_shared<std::promise<void>>();
+	auto future        = promise->get_future();
+	connection_registry_->on_empty(
+	    [deadline, promise, on_stopped = std::move(on_stopped), count = connections.size()]()
+	    {
+		    post(deadline->get_executor(), [deadline]() { deadline->cancel(); });
+		    Logger::info(TAG, CONSOLE_COLOR,
+		                 "WebSocket server on port {} has been stopped successfully ({} connection(s) closed).",
+		                 ws_server_config.server_port, count);
+		    if (on_stopped)
+			    on_stopped();
+		    promise->set_value();
+	    });
+	return future;
 }
 
-AsyncSocketAcceptor::AsyncSocketAcceptor(io_context& io_context)
-    : io_context_(io_context), acceptor_(make_shared<ip::tcp::acceptor>(
-                                   io_context, ip::tcp::endpoint(ip::tcp::v4(), ws_server_config.server_port)))
+void AsyncWebSocketServer::schedule_session_manage()
+{
+	session_log_timer_.expires_after(seconds(ws_server_config.session_log_period));
+	session_log_timer_.async_wait(
+	    [self = shared_from_this()](const boost::system::error_code& ec)
+	    {
+		    if (ec || flag_stop_server)
+			    return;
+		    on_session_manage();
+		    self->schedule_session_manage();
+	    });
+}
+
+AsyncSocketAcceptor::AsyncSocketAcceptor(io_context& io_context, IoContextPool& io_context_pool,
+                                         const shared_ptr<AsyncConnectionRegistry>& connection_registry,
+                                         const shared_ptr<BufferPool>& buffer_pool)
+    : io_context_(io_context), io_context_pool_(io_context_pool), connection_registry_(connection_registry),
+      buffer_pool_(buffer_pool),
+      acceptor_(make_shared<ip::tcp::acceptor>(io_context,
+                                               ip::tcp::endpoint(ip::tcp::v4(), ws_server_config.server_port)))
 {
 }
 
 void AsyncSocketAcceptor::do_accept()
 {
-	auto socket = make_shared<Socket>(io_context_);
+	// Admission is only decided once the connection is there; either way the socket stays on its pool io_context and
+	// everything done with it runs there, the acceptor's io_context only accepts
+	auto socket = make_shared<Socket>(io_context_pool_.get_io_context());
 	if (acceptor_ && acceptor_->is_open())
 	{
 		acceptor_->async_accept(
@@ -112,14 +190,26 @@ void AsyncSocketAcceptor::do_accept()
 			    {
 				    if (!ec)
 				    {
-					    const auto connection = make_shared<AsyncWebSocketConnection>(socket);
-					    connection->upgrade();
+					    if (at_capacity())
+					    {
+						    post(socket->get_executor(),
+						         [socket] { reject_socket(socket, boost::beast::http::status::service_unavailable); });
+					    }
+					    else
+					    {
+						    // Registered right away, so the next accept already counts it against the capacity
+						    const auto executor   = socket->get_executor();
+						    const auto connection = make_shared<AsyncWebSocketConnection>(socket, connection_registry_,
+						                                                                  buffer_pool_);
+						    connection_registry_->add(connection);
+						    post(executor, [connection] { connection->upgrade(); });
+					    }
 				    }
 				    else if (!flag_stop_server)
 				    {
-					    Logger::log_error(TAG, fmt::format("[Accept] Error: remote <{}:{}>, error: {} ({})",
-					                                       socket->remote_endpoint().address().to_string(),
-					                                       socket->remote_endpoint().port(), ec.message(), ec.value()));
+					    Logger::error(TAG, "[Accept] Error: remote <{}:{}>, error: {} ({})",
+					                  socket->remote_endpoint().address().to_string(), socket->remote_endpoint().port(),
+					                  ec.message(), ec.value());
 				    }
 				    do_accept();
 			    }
@@ -135,90 +225,167 @@ void AsyncSocketAcceptor::do_accept()
 	}
 }
 
-AsyncWebSocketConnection::AsyncWebSocketConnection(const shared_ptr<Socket>& socket)
-    : WebSocketConnection(make_shared<WebSocket>(std::move(*socket)))
+bool AsyncSocketAcceptor::at_capacity() const
+{
+	const auto limit = ws_server_config.max_session + ws_server_config.max_pending_connection;
+	return connection_registry_->size() >= static_cast<size_t>(max(0, limit));
+}
+
+AsyncWebSocketConnection::AsyncWebSocketConnection(const shared_ptr<Socket>& socket,
+                                                   const shared_ptr<AsyncConnectionRegistry>& connection_registry,
+                                                   const shared_ptr<BufferPool>& buffer_pool)
+    : WebSocketConnection(make_shared<WebSocket>(std::move(*socket))), device_ip_(remote_address(ws_->next_layer())),
+      device_id_(remote_id(ws_->next_layer())), idle_timer_(ws_->get_executor()), last_received_(steady_clock::now()),
+      connection_registry_(connection_registry), buffer_pool_(buffer_pool)
+{
+}
+
+AsyncWebSocketConnection::~AsyncWebSocketConnection()
 {
+	connection_registry_->remove(this);
 }
 
 void AsyncWebSocketConnection::upgrade()
 {
-	const auto self = shared_from_this();
-	if (ws_ && ws_->next_layer().is_open())
+	if (!ws_ || !ws_->next_layer().is_open())
 	{
-		ws_->async_accept(
-		    [self](const boost::system::error_code& ec)
+		if (!flag_stop_server)
+		{
+			Logger::log_error(
+			    TAG, "[Upgrade] Error: Cannot attempt to upgrade because the socket connection is already closed.");
+		}
+		return;
+	}
+
+	// The idle timer also bounds a client that never completes its upgrade request
+	arm_idle_timer();
+	boost::beast::http::async_read(
+	    ws_->next_layer(), upgrade_buffer_, upgrade_request_,
+	    [self = shared_from_this()](const boost::system::error_code& ec, const size_t)
+	    {
+		    if (ec)
 		    {
-			    if (self->ws_ && self->ws_->is_open() && self->ws_->next_layer().is_open())
+			    if (!flag_stop_server && ec != error::operation_aborted)
 			    {
-				    if (!ec)
-				    {
-					    self->do_read();
-				    }
-				    else if (!flag_stop_server)
-				    {
-					    const auto remote_endpoint = self->ws_->next_layer().remote_endpoint();
-					    Logger::log_error(TAG, fmt::format("[Upgrade] Error: remote <{}:{}>, error: {} ({})",
-					                                       remote_endpoint.address().to_string(),
-					                                       remote_endpoint.port(), ec.message(), ec.value()));
-				    }
+				    Logger::error(TAG, "[Upgrade] Error reading request: remote <{}>, error: {} ({})", self->device_ip_,
+				                  ec.message(), ec.value());
+			    }
+			    self->force_close();
+			    return;
+		    }
+		    if (!boost::beast::websocket::is_upgrade(self->upgrade_request_))
+		    {
+			    self->idle_timer_.cancel();
+			    reject_socket(make_shared<Socket>(std::move(self->ws_->next_layer())),
+			                  boost::beast::http::status::bad_request);
+			    return;
+		    }
+
+		    // Decided before any WebSocket state exists, a rejected device costs one request parse and a 503
+		    self->admission_ = on_session_admit(self->upgrade_request_, self->device_ip_);
+		    if (!self->admission_)
+		    {
+			    self->idle_timer_.cancel();
+			    reject_socket(make_shared<Socket>(std::move(self->ws_->next_layer())),
+			                  boost::beast::http::status::service_unavailable);
+			    return;
+		    }
+		    self->accept_websocket();
+	    });
+}
+
+void AsyncWebSocketConnection::accept_websocket()
+{
+	const auto self = shared_from_this();
+	// Bounds the opening and closing handshakes, idle detection is done by idle_timer_
+	ws_->set_option(boost::beast::websocket::stream_base::timeout::suggested(boost::beast::role_type::server));
+	ws_->async_accept(
+	    upgrade_request_,
+	    [self](const boost::system::error_code& ec)
+	    {
+		    self->upgrade_request_ = {};
+		    self->upgrade_buffer_  = {};
+		    if (self->ws_ && self->ws_->is_open() && self->ws_->next_layer().is_open())
+		    {
+			    if (!ec)
+			    {
+				    self->last_received_ = steady_clock::now();
+				    self->arm_idle_timer();
+				    self->do_read();
 			    }
 			    else if (!flag_stop_server)
 			    {
-				    Logger::log_error(TAG, "[Upgrade] Error: Socket connection is already closed.");
+				    Logger::error(TAG, "[Upgrade] Error: remote <{}>, error: {} ({})", self->device_ip_, ec.message(),
+				                  ec.value());
 			    }
-		    });
-	}
-	else if (!flag_stop_server)
-	{
-		Logger::log_error(
-		    TAG, "[Upgrade] Error: Cannot attempt to upgrade because the socket connection is already closed.");
-	}
+		    }
+		    else if (!flag_stop_server)
+		    {
+			    Logger::log_error(TAG, "[Upgrade] Error: Socket connection is already closed.");
+		    }
+	    });
 }
 
 void AsyncWebSocketConnection::do_read()
 {
-	auto buffer     = make_shared<Buffer>();
+	// Reuse the previous buffer if its consumer is done with it, otherwise let the consumer keep it
+	if (read_buffer_ && read_buffer_.use_count() == 1)
+	{
+		read_buffer_->clear();
+	}
+	else
+	{
+		read_buffer_ = buffer_pool_->acquire();
+	}
 	const auto self = shared_from_this();
 	if (ws_ && ws_->is_open() && ws_->next_layer().is_open())
 	{
+		// The handler must not capture the buffer, otherwise the next do_read() always sees it as in use
 		ws_->async_read(
-		    *buffer,
-		    [self, buffer](const boost::system::error_code& ec, const size_t)
+		    *read_buffer_,
+		    [self](const boost::system::error_code& ec, const size_t)
 		    {
-			    if (self->ws_ && self->ws_->is_open() && self->ws_->next_layer().is_open())
+			    if (ec)
 			    {
-				    const std::string device_ip = self->ws_->next_layer().remote_endpoint().address().to_string();
-				    if (!ec)
+				    if (ec != boost::beast::websocket::error::closed && !flag_stop_server)
 				    {
-					    if (ws_session_map.contains(device_ip))
-					    {
-						    ws_session_map.visit(device_ip,
-						                         [&](const auto& pair)
-						                         {
-							                         const auto& session = pair.second;
-							                         on_session_read(session, buffer);
-						                         });
-					    }
-					    else
-					    {
-						    auto session = std::make_shared<Session>(self->ws_);
-						    ws_session_map.insert_or_assign(device_ip, session);
-						    on_session_created(session, buffer);
-					    }
+					    Logger::error(TAG, "[Read] Error: remote: <{}>, error: {} ({})", self->device_ip_, ec.message(),
+					                  ec.value());
+				    }
+				    self->on_closed();
+				    return;
+			    }
+
+			    // Only a timestamp per frame, the idle timer re-arms itself lazily when it fires
+			    self->last_received_ = steady_clock::now();
+			    if (self->session_)
+			    {
+				    // Fast path: no map lookup and no bucket lock while the frame is processed
+				    on_session_read(self->session_, self->read_buffer_);
+			    }
+			    else
+			    {
+				    const auto session = std::make_shared<Session>(
+				        self->ws_, nullptr, self->device_ip_, self->device_id_,
+				        std::make_shared<OutboundQueue>(self->ws_, ws_server_config.max_outbound_bytes),
+				        self->admission_);
+				    on_session_created(session, self->read_buffer_);
+				    if (!session->admission)
+				    {
+					    // Refused once identified (e.g. over its device type quota), the close op drains the stream
+					    self->idle_timer_.cancel();
+					    self->ws_->async_close(boost::beast::websocket::close_code::try_again_later,
+					                           [self](const boost::system::error_code&) {});
+					    return;
 				    }
-				    else
+				    if (session->info)
 				    {
-					    Logger::log_error(TAG,
-					                      fmt::format("[Read] Error: remote: <{}:{}>, error: {} ({})",
-					                                  self->ws_->next_layer().remote_endpoint().address().to_string(),
-					                                  self->ws_->next_layer().remote_endpoint().port(), ec.message(),
-					                                  ec.value()));
+					    // Publish only a fully initialized session
+					    ws_session_map.insert_or_assign(self->device_id_, session);
+					    self->session_ = session;
 				    }
-				    self->do_read();
 			    }
-			    else if (!flag_stop_server)
-				    Logger::log_error(TAG, "[Read] Error: WebSocket connection is already closed. The session will be "
-				                           "removed by session management.");
+			    self->do_read();
 		    });
 	}
 	else if (!flag_stop_server)
@@ -227,3 +394,137 @@ void AsyncWebSocketConnection::do_read()
 		                  "[Read] Error: Cannot attempt to read because the WebSocket connection is already closed.");
 	}
 }
+
+void AsyncWebSocketConnection::arm_idle_timer()
+{
+	idle_timer_.expires_at(last_received_ + seconds(ws_server_config.session_timeout));
+	idle_timer_.async_wait(
+	    [self = shared_from_this()](const boost::system::error_code& ec)
+	    {
+		    if (!ec)
+		    {
+			    self->on_idle_timer();
+		    }
+	    });
+}
+
+void AsyncWebSocketConnection::on_idle_timer()
+{
+	const auto now = steady_clock::now();
+	if (now < last_received_ + seconds(ws_server_config.session_timeout))
+	{
+		// Data arrived since the timer was armed, wait for the remainder of the new deadline
+		arm_idle_timer();
+		return;
+	}
+
+	Logger::warn(TAG, "[Timeout] session '{}' will be disconnected by timeout (last received: {}s ago)", device_ip_,
+	             duration_cast<seconds>(now - last_received_).count());
+	if (ws_->is_open())
+	{
+		// The pending read completes with an error afterwards and runs on_closed()
+		close_websocket(ws_, device_ip_);
+	}
+	else
+	{
+		// Still waiting for the upgrade request, the pending read fails once the socket is closed
+		force_close();
+	}
+}
+
+void AsyncWebSocketConnection::on_closed()
+{
+	idle_timer_.cancel();
+	if (session_)
+	{
+		// A reconnected device may already own the map entry under the same address
+		ws_session_map.erase_if(device_id_, [this](const auto& pair) { return pair.second == session_; });
+		on_session_closed(session_);
+		session_.reset();
+	}
+}
+
+void AsyncWebSocketConnection::close()
+{
+	post(ws_->get_executor(),
+	     [self = shared_from_this()]()
+	     {
+		     if (self->ws_->is_open())
+		     {
+			     close_websocket(self->ws_, self->device_ip_);
+		     }
+		     else
+		     {
+			     // Not upgraded yet (or already failed), there is no close handshake to perform
+			     self->force_close();
+		     }
+	     });
+}
+
+void AsyncWebSocketConnection::force_close()
+{
+	post(ws_->get_executor(),
+	     [self = shared_from_this()]()
+	     {
+		     boost::system::error_code ec;
+		     self->idle_timer_.cancel();
+		     self->ws_->next_layer().close(ec);
+	     });
+}
+
+void AsyncConnectionRegistry::add(const shared_ptr<AsyncWebSocketConnection>& connection)
+{
+	lock_guard lock(mutex_);
+	connections_.emplace(connection.get(), connection);
+}
+
+void AsyncConnectionRegistry::remove(const AsyncWebSocketConnection* connection)
+{
+	vector<function<void()>> callbacks;
+	{
+		lock_guard lock(mutex_);
+		connections_.erase(connection);
+		if (connections_.empty())
+		{
+			callbacks.swap(empty_callbacks_);
+		}
+	}
+	for (const auto& callback : callbacks)
+	{
+		callback();
+	}
+}
+
+vector<shared_ptr<AsyncWebSocketConnection>> AsyncConnectionRegistry::snapshot() const
+{
+	vector<shared_ptr<AsyncWebSocketConnection>> connections;
+	lock_guard lock(mutex_);
+	connections.reserve(connections_.size());
+	for (const auto& [_, connection] : connections_)
+	{
+		if (auto alive = connection.lock())
+		{
+			connections.push_back(std::move(alive));
+		}
+	}
+	return connections;
+}
+
+size_t AsyncConnectionRegistry::size() const
+{
+	lock_guard lock(mutex_);
+	return connections_.size();
+}
+
+void AsyncConnectionRegistry::on_empty(function<void()> callback)
+{
+	{
+		lock_guard lock(mutex_);
+		if (!connections_.empty())
+		{
+			empty_callbacks_.push_back(std::move(callback));
+			return;
+		}
+	}
+	callback();
+}
@@ -0,0 +1,69 @@
+#include "server/buffer_pool.hpp"
+
+using namespace std;
+
+BufferPool::BufferPool(const size_t capacity, const size_t max_buffer_bytes)
+    : capacity_(capacity), max_buffer_bytes_(max_buffer_bytes)
+{
+	free_buffers_.reserve(capacity_);
+}
+
+shared_ptr<BufferPool::Buffer> BufferPool::acquire()
+{
+	unique_ptr<Buffer> buffer;
+	{
+		lock_guard lock(mutex_);
+		if (!free_buffers_.empty())
+		{
+			buffer = std::move(free_buffers_.back());
+			free_buffers_.pop_back();
+		}
+	}
+	if (buffer)
+	{
+		hits_.fetch_add(1, memory_order_relaxed);
+	}
+	else
+	{
+		misses_.fetch_add(1, memory_order_relaxed);
+		buffer = make_unique<Buffer>();
+	}
+
+	// The pool may be gone (server restarted) by the time the last consumer releases the buffer
+	return {buffer.release(), [weak_pool = weak_from_this()](Buffer* released)
+	        {
+		        if (const auto pool = weak_pool.lock())
+			        pool->recycle(released);
+		        else
+			        delete released;
+	        }};
+}
+
+BufferPool::Stats BufferPool::stats() const
+{
+	Stats stats;
+	stats.hits      = hits_.load(memory_order_relaxed);
+	stats.misses    = misses_.load(memory_order_relaxed);
+	stats.discarded = discarded_.load(memory_order_relaxed);
+	{
+		lock_guard lock(mutex_);
+		stats.pooled = free_buffers_.size();
+	}
+	return stats;
+}
+
+void BufferPool::recycle(Buffer* buffer)
+{
+	unique_ptr<Buffer> owned(buffer);
+	if (owned->capacity() <= max_buffer_bytes_)
+	{
+		owned->clear(); // Keeps the allocation, only resets the readable/writable regions
+		lock_guard lock(mutex_);
+		if (free_buffers_.size() < capacity_)
+		{
+			free_buffers_.push_back(std::move(owned));
+			return;
+		}
+	}
+	discarded_.fetch_add(1, memory_order_relaxed);
+}
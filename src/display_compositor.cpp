@@ -0,0 +1,188 @@
+#include "vision/display_compositor.hpp"
+#include "utils/logging_utils.hpp"
+#include <cmath>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace chrono;
+
+namespace
+{
+constexpr std::string_view TAG           = "DisplayCompositor";
+constexpr std::string_view MOSAIC_WINDOW = "Solicare Cameras";
+} // namespace
+
+DisplayCompositor::DisplayCompositor(const DisplayConfig& config) : config_(config)
+{
+	thread_ = thread([this] { run(); });
+}
+
+DisplayCompositor::~DisplayCompositor()
+{
+	{
+		lock_guard lock(mutex_);
+		stopping_ = true;
+	}
+	stopped_.notify_one();
+	if (thread_.joinable())
+		thread_.join();
+}
+
+void DisplayCompositor::publish(const std::string& window, const cv::Mat& frame, Overlay overlay)
+{
+	if (frame.empty())
+		return;
+	cv::Mat copy;
+	{
+		const lock_guard lock(mutex_);
+		copy = std::move(slots_[window].spare);
+	}
+	frame.copyTo(copy); // Outside the lock, into a buffer handed back earlier: no allocation once warmed up
+
+	const lock_guard lock(mutex_);
+	auto& slot = slots_[window];
+	if (slot.fresh)
+		replaced_.fetch_add(1, memory_order_relaxed);
+	swap(slot.frame, copy);
+	slot.spare   = std::move(copy); // The replaced frame, or the one the display thread handed back
+	slot.overlay = std::move(overlay);
+	slot.fresh   = true;
+}
+
+void DisplayCompositor::close(const std::string& window)
+{
+	const lock_guard lock(mutex_);
+	closed_.push_back(window);
+}
+
+void DisplayCompositor::close_all()
+{
+	const lock_guard lock(mutex_);
+	closing_ = true;
+}
+
+void DisplayCompositor::run()
+{
+	const auto period = duration_cast<steady_clock::duration>(duration<double>(1.0 / max(1.0, config_.max_fps)));
+	vector<pair<string, Overlay>> fresh;
+	vector<string> closed;
+	bool gui_failed   = false;
+	bool windows_open = false;
+	auto next_refresh = steady_clock::now();
+
+	unique_lock lock(mutex_);
+	while (!stopped_.wait_until(lock, next_refresh, [this] { return stopping_; }))
+	{
+		// Late refreshes are not caught up, the cap holds after a slow one
+		next_refresh = max(next_refresh + period, steady_clock::now());
+
+		const bool closing = exchange(closing_, false);
+		if (closing)
+		{
+			slots_.clear();
+			shown_frames_.clear();
+		}
+		closed.clear();
+		for (const auto& window : exchange(closed_, {}))
+		{
+			slots_.erase(window);
+			if (shown_frames_.erase(window) > 0)
+				closed.push_back(window); // Only windows that were ever shown exist
+		}
+		fresh.clear();
+		for (auto& [window, slot] : slots_)
+		{
+			if (!slot.fresh)
+				continue;
+			slot.fresh = false;
+			swap(slot.frame, shown_frames_[window]);
+			fresh.emplace_back(window, std::move(slot.overlay));
+		}
+		// Without a new frame the open windows still need their events pumped, or they stop responding
+		if (gui_failed || (fresh.empty() && closed.empty() && !closing && !windows_open))
+			continue;
+
+		lock.unlock();
+		try
+		{
+			if (closing)
+				cv::destroyAllWindows();
+			if (!config_.mosaic)
+			{
+				for (const auto& window : closed)
+					cv::destroyWindow(window);
+			}
+			for (auto& [window, overlay] : fresh)
+			{
+				auto& frame = shown_frames_[window];
+				if (overlay)
+					overlay(frame);
+				if (!config_.mosaic)
+					cv::imshow(window, frame);
+			}
+			if (config_.mosaic && shown_frames_.empty() && !closed.empty())
+				cv::destroyWindow(string(MOSAIC_WINDOW)); // Its last tile closed
+			else if (config_.mosaic && (!fresh.empty() || !closed.empty()))
+			{
+				compose_mosaic();
+				cv::imshow(string(MOSAIC_WINDOW), mosaic_);
+			}
+			windows_open = !shown_frames_.empty();
+			cv::waitKey(1); // Pumps the GUI events on every refresh, also the closing ones of destroyed windows
+			shown_.fetch_add(fresh.size(), memory_order_relaxed);
+		}
+		catch (const cv::Exception& e)
+		{
+			// No usable display, e.g. started without a desktop session: frames keep being dropped from now on
+			Logger::error(TAG, "Display unavailable, run headless instead (SOLICARE_HEADLESS=1): {}", e.what());
+			gui_failed = true;
+		}
+		lock.lock();
+	}
+	lock.unlock();
+
+	if (!gui_failed)
+	{
+		try
+		{
+			cv::destroyAllWindows();
+		}
+		catch (const cv::Exception&)
+		{
+		}
+	}
+}
+
+void DisplayCompositor::compose_mosaic()
+{
+	const int count       = static_cast<int>(shown_frames_.size());
+	const int columns     = max(1, static_cast<int>(ceil(sqrt(static_cast<double>(count)))));
+	const int rows        = max(1, (count + columns - 1) / columns);
+	const int tile_width  = max(16, config_.mosaic_tile_width);
+	const int tile_height = tile_width * 9 / 16;
+
+	mosaic_.create(rows * tile_height, columns * tile_width, CV_8UC3);
+	mosaic_.setTo(cv::Scalar::all(0));
+	int index = 0;
+	for (const auto& [window, frame] : shown_frames_)
+	{
+		const cv::Rect tile((index % columns) * tile_width, (index / columns) * tile_height, tile_width, tile_height);
+		++index;
+		if (frame.empty())
+			continue;
+
+		// Fitted into the tile keeping the aspect ratio, the window name on top
+		const double scale = min(static_cast<double>(tile_width) / frame.cols,
+		                         static_cast<double>(tile_height) / frame.rows);
+		const cv::Size fitted(max(1, static_cast<int>(frame.cols * scale)),
+		                      max(1, static_cast<int>(frame.rows * scale)));
+		cv::Mat target = mosaic_(cv::Rect(tile.x + (tile_width - fitted.width) / 2,
+		                                  tile.y + (tile_height - fitted.height) / 2, fitted.width, fitted.height));
+		cv::resize(frame, target, fitted, 0, 0, cv::INTER_AREA);
+
+		const auto label = cv::getTextSize(window, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, nullptr);
+		cv::putText(mosaic_, window, cv::Point(tile.x + (tile_width - label.width) / 2, tile.y + 20),
+		            cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1, cv::LINE_AA);
+	}
+}
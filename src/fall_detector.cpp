@@ -0,0 +1,177 @@
+#include "vision/fall_detector.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <optional>
+
+using namespace std;
+
+namespace
+{
+constexpr double MAX_SAMPLE_GAP = 1.0; // Seconds between samples across which no feature is computed
+
+// Mean of the confident ones of two symmetric keypoints of one sample
+optional<cv::Point2f> centre_of(const KeypointWindow& window, const size_t sample, const int left, const int right)
+{
+	const bool has_left  = window.confidence(left)[sample] >= PoseModel::KEYPOINT_THRESHOLD;
+	const bool has_right = window.confidence(right)[sample] >= PoseModel::KEYPOINT_THRESHOLD;
+	const cv::Point2f left_point(window.x(left)[sample], window.y(left)[sample]);
+	const cv::Point2f right_point(window.x(right)[sample], window.y(right)[sample]);
+	if (has_left && has_right)
+		return cv::Point2f((left_point.x + right_point.x) / 2, (left_point.y + right_point.y) / 2);
+	if (has_left)
+		return left_point;
+	if (has_right)
+		return right_point;
+	return nullopt;
+}
+} // namespace
+
+double FallDetector::seconds_since(const Clock::time_point since, const Clock::time_point now) const
+{
+	return chrono::duration<double>(now - since).count();
+}
+
+void FallDetector::update(const KeypointWindow& window)
+{
+	if (window.empty())
+		return;
+	const auto timestamps = window.timestamps();
+	const size_t newest   = window.size() - 1;
+	const auto timestamp  = timestamps[newest];
+	const auto hips       = centre_of(window, newest, PoseModel::LEFT_HIP, PoseModel::RIGHT_HIP);
+	if (!hips || !centre_of(window, newest, PoseModel::LEFT_SHOULDER, PoseModel::RIGHT_SHOULDER) ||
+	    window.height()[newest] <= 0.0f)
+	{
+		update_missing(timestamp); // Seen, but not enough of the torso to judge
+		return;
+	}
+
+	// Samples of the last window_seconds, not reaching back across a gap
+	size_t first = newest;
+	while (first > 0 && seconds_since(timestamps[first - 1], timestamp) <= config_.window_seconds &&
+	       seconds_since(timestamps[first - 1], timestamps[first]) <= MAX_SAMPLE_GAP)
+		--first;
+
+	int samples = 0, upright = 0;
+	double angle_sum = 0.0, aspect_sum = 0.0, upright_length_sum = 0.0, newest_length = 0.0;
+	double time_sum = 0.0, centre_sum = 0.0, time_square_sum = 0.0, time_centre_sum = 0.0;
+	for (size_t sample = first; sample <= newest; ++sample)
+	{
+		const auto shoulders   = centre_of(window, sample, PoseModel::LEFT_SHOULDER, PoseModel::RIGHT_SHOULDER);
+		const auto sample_hips = centre_of(window, sample, PoseModel::LEFT_HIP, PoseModel::RIGHT_HIP);
+		if (!shoulders || !sample_hips || window.height()[sample] <= 0.0f)
+			continue;
+
+		const cv::Point2f torso = *shoulders - *sample_hips;
+		const double length     = max(1.0, static_cast<double>(hypot(torso.x, torso.y)));
+		const double angle      = atan2(abs(torso.x), abs(torso.y)) * 180.0 / numbers::pi;
+		const double time       = seconds_since(timestamp, timestamps[sample]); // <= 0
+		const double centre_y   = (shoulders->y + sample_hips->y) / 2.0;
+		++samples;
+		angle_sum += angle;
+		aspect_sum += static_cast<double>(window.width()[sample]) / window.height()[sample];
+		time_sum += time;
+		centre_sum += centre_y;
+		time_square_sum += time * time;
+		time_centre_sum += time * centre_y;
+		// The upright torso length is the scale, a lying or falling torso is foreshortened
+		if (angle < config_.upright_angle)
+		{
+			++upright;
+			upright_length_sum += length;
+		}
+		newest_length = length;
+	}
+
+	if (upright > 0)
+		torso_length_ = upright_length_sum / upright;
+	else if (!has_sample_ || seconds_since(last_sample_, timestamp) > MAX_SAMPLE_GAP)
+		torso_length_ = newest_length; // No upright sample yet, the best scale there is
+	torso_angle_  = angle_sum / samples;
+	aspect_ratio_ = aspect_sum / samples;
+
+	// Least-squares slope of the body centre's height over the window in torso lengths per second, 0 with one sample
+	const double time_variance = samples * time_square_sum - time_sum * time_sum;
+	const double covariance    = samples * time_centre_sum - time_sum * centre_sum;
+	vertical_speed_            = time_variance > 1e-9 ? covariance / time_variance / torso_length_ : 0.0;
+	has_sample_                = true;
+	last_sample_               = timestamp;
+
+	if (vertical_speed_ >= config_.descent_speed)
+		last_descent_ = timestamp;
+
+	const BODY_POSTURE instant = instant_posture(window, newest, hips->y);
+	if (instant == POSTURE_LYING)
+	{
+		upright_since_ = {};
+		if (lying_since_ == Clock::time_point{})
+		{
+			lying_since_         = timestamp;
+			lying_after_descent_ = last_descent_ != Clock::time_point{} &&
+			                       seconds_since(last_descent_, timestamp) <= config_.descent_to_lying;
+		}
+		if (posture_ == POSTURE_FALLEN)
+			return;
+		// A fall is only reported once the person stays down, until then it is plain lying
+		posture_ = lying_after_descent_ && seconds_since(lying_since_, timestamp) >= config_.sustained_lying
+		               ? POSTURE_FALLEN
+		               : POSTURE_LYING;
+		return;
+	}
+
+	lying_since_         = {};
+	lying_after_descent_ = false;
+	if (posture_ == POSTURE_FALLEN)
+	{
+		if (upright_since_ == Clock::time_point{})
+			upright_since_ = timestamp;
+		if (seconds_since(upright_since_, timestamp) < config_.recovery)
+			return;
+	}
+	posture_ = instant;
+}
+
+void FallDetector::update_missing(const Clock::time_point timestamp)
+{
+	// A fallen person who drops out of view, e.g. behind furniture, stays fallen
+	if (has_sample_ && posture_ != POSTURE_FALLEN && seconds_since(last_sample_, timestamp) > config_.lost_timeout)
+		reset();
+}
+
+void FallDetector::reset()
+{
+	const auto config = config_;
+	*this             = FallDetector(config);
+}
+
+BODY_POSTURE FallDetector::instant_posture(const KeypointWindow& window, const size_t sample, const float hip_y) const
+{
+	if (torso_angle_ > config_.lying_angle || aspect_ratio_ > config_.lying_aspect_ratio)
+		return POSTURE_LYING;
+	if (torso_angle_ > config_.upright_angle)
+		return posture_ == POSTURE_SITTING ? POSTURE_SITTING : POSTURE_STANDING; // Leaning, keep what it was
+
+	// Upright: thighs close to horizontal in the image mean sitting
+	const auto knees = centre_of(window, sample, PoseModel::LEFT_KNEE, PoseModel::RIGHT_KNEE);
+	if (knees && (knees->y - hip_y) < config_.sitting_thigh_drop * torso_length_)
+		return POSTURE_SITTING;
+	return POSTURE_STANDING;
+}
+
+std::string_view to_string(const BODY_POSTURE posture)
+{
+	switch (posture)
+	{
+	case POSTURE_STANDING:
+		return "standing";
+	case POSTURE_SITTING:
+		return "sitting";
+	case POSTURE_LYING:
+		return "lying";
+	case POSTURE_FALLEN:
+		return "fallen";
+	default:
+		return "unknown";
+	}
+}
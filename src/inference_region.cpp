@@ -0,0 +1,55 @@
+#include "vision/inference_region.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+void InferenceRegion::configure(const InferenceRegionConfig& config)
+{
+	const lock_guard lock(mutex_);
+	config_     = config;
+	box_        = nullopt;
+	detections_ = 0;
+}
+
+optional<cv::Rect> InferenceRegion::next(const cv::Size frame)
+{
+	if (!config_.enabled || frame.width <= 0 || frame.height <= 0)
+		return nullopt;
+
+	const lock_guard lock(mutex_);
+	if (!box_ || ++detections_ >= config_.full_frame_interval)
+	{
+		detections_ = 0;
+		return nullopt;
+	}
+
+	// A crop of side s scales by input_size / s, the full frame by INPUT_SIZE / its longer side
+	const float side = max(box_->width, box_->height) * (1.0f + 2.0f * config_.padding);
+	if (side * PoseModel::INPUT_SIZE > static_cast<float>(config_.input_size * max(frame.width, frame.height)))
+		return nullopt;
+
+	// Centred on the box, shifted back inside the frame at its borders
+	const int width      = min(frame.width, static_cast<int>(ceil(side)));
+	const int height     = min(frame.height, static_cast<int>(ceil(side)));
+	const float centre_x = box_->x + box_->width / 2;
+	const float centre_y = box_->y + box_->height / 2;
+	const int x          = clamp(static_cast<int>(lround(centre_x - side / 2)), 0, frame.width - width);
+	const int y          = clamp(static_cast<int>(lround(centre_y - side / 2)), 0, frame.height - height);
+	return cv::Rect(x, y, width, height);
+}
+
+bool InferenceRegion::following() const
+{
+	const lock_guard lock(mutex_);
+	return config_.enabled && box_.has_value();
+}
+
+void InferenceRegion::update(const PoseModel::PoseDetection* person)
+{
+	const lock_guard lock(mutex_);
+	if (person && person->box.width > 0.0f && person->box.height > 0.0f)
+		box_ = person->box;
+	else
+		box_ = nullopt;
+}
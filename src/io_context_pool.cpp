@@ -0,0 +1,106 @@
+#include "server/io_context_pool.hpp"
+#include "utils/logging_utils.hpp"
+#include <boost/asio/error.hpp>
+#include <boost/system/system_error.hpp>
+#include <fmt/core.h>
+
+using namespace std;
+using namespace boost::asio;
+
+namespace
+{
+constexpr std::string_view TAG = "IoContextPool";
+constexpr auto CONSOLE_COLOR   = Logger::ConsoleColor::BLUE;
+} // namespace
+
+IoContextPool::IoContextPool(size_t pool_size)
+{
+	if (pool_size == 0)
+	{
+		pool_size = max(1u, thread::hardware_concurrency());
+	}
+	io_contexts_.reserve(pool_size);
+	work_guards_.reserve(pool_size);
+	for (size_t i = 0; i < pool_size; ++i)
+	{
+		// concurrency_hint = 1: each io_context is only ever run by its own thread
+		io_contexts_.emplace_back(make_unique<io_context>(1));
+		work_guards_.emplace_back(make_work_guard(*io_contexts_.back()));
+	}
+}
+
+IoContextPool::~IoContextPool()
+{
+	stop();
+}
+
+void IoContextPool::run()
+{
+	if (!threads_.empty())
+		return;
+
+	threads_.reserve(io_contexts_.size());
+	for (size_t i = 0; i < io_contexts_.size(); ++i)
+	{
+		threads_.emplace_back(
+		    [this, i]()
+		    {
+			    auto& ioc = *io_contexts_[i];
+			    while (!ioc.stopped())
+			    {
+				    try
+				    {
+					    ioc.run();
+				    }
+				    catch (const boost::system::system_error& e)
+				    {
+					    if (e.code() != error::operation_aborted)
+					    {
+						    Logger::error(TAG, "io_context[{}].run() system_error: {} (code: {})", i, e.what(),
+						                  e.code().value());
+					    }
+				    }
+				    catch (const std::exception& e)
+				    {
+					    Logger::error(TAG, "io_context[{}].run() exception: {}", i, e.what());
+				    }
+				    catch (...)
+				    {
+					    Logger::error(TAG, "io_context[{}].run() unknown exception occurred", i);
+				    }
+			    }
+		    });
+	}
+	Logger::info(TAG, CONSOLE_COLOR, "Started {} io_context runner thread(s).", threads_.size());
+}
+
+void IoContextPool::stop()
+{
+	for (auto& work_guard : work_guards_)
+	{
+		work_guard.reset();
+	}
+	for (const auto& ioc : io_contexts_)
+	{
+		ioc->stop();
+	}
+	for (auto& thread : threads_)
+	{
+		if (thread.joinable())
+		{
+			thread.join();
+		}
+	}
+	threads_.clear();
+}
+
+io_context& IoContextPool::get_io_context()
+{
+	const auto index = next_io_context_.fetch_add(1, memory_order_relaxed) % io_contexts_.size();
+	return *io_contexts_[index];
+}
+
+size_t IoContextPool::size() const
+{
+	return io_contexts_.size();
+}
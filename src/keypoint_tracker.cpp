@@ -0,0 +1,189 @@
+#include "vision/keypoint_tracker.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+constexpr double MOTION_SMOOTHING = 0.3; // Weight of the newest frame in the running keypoint motion
+
+int confident_keypoints(const PoseModel::PoseDetection& person)
+{
+	const auto confident = [](const float confidence) { return confidence >= PoseModel::KEYPOINT_THRESHOLD; };
+	return static_cast<int>(count_if(person.confidence.begin(), person.confidence.end(), confident));
+}
+} // namespace
+
+void KeypointTracker::configure(const KeypointTrackerConfig& config)
+{
+	config_ = config;
+	following_.store(false);
+}
+
+bool KeypointTracker::needs_detection(const double utilization)
+{
+	if (!config_.enabled || !following_.load() || confidence() < config_.min_confidence)
+	{
+		since_detection_.store(0);
+		return true;
+	}
+	if (since_detection_.fetch_add(1) + 1 >= interval(utilization))
+	{
+		since_detection_.store(0);
+		return true;
+	}
+	return false;
+}
+
+int KeypointTracker::interval(const double utilization) const
+{
+	const int shortest = max(1, config_.min_interval);
+	const int longest  = max(shortest, config_.max_interval);
+
+	// Linear between the still and the fast motion
+	const double span     = config_.fast_motion - config_.still_motion;
+	const double fastness = span > 0.0 ? clamp((motion() - config_.still_motion) / span, 0.0, 1.0) : 1.0;
+	double frames         = longest - fastness * (longest - shortest);
+
+	// A saturated inference thread cannot keep up anyway, fewer detector runs keep the latency of every camera down
+	if (config_.busy_utilization < 1.0 && utilization > config_.busy_utilization)
+		frames += (longest - frames) * min(1.0, (utilization - config_.busy_utilization) /
+		                                            (1.0 - config_.busy_utilization));
+	return clamp(static_cast<int>(lround(frames)), shortest, longest);
+}
+
+void KeypointTracker::detected(const PoseModel::PoseDetection* person, const cv::Mat& gray)
+{
+	if (!person || gray.empty())
+	{
+		following_.store(false);
+		confidence_.store(0.0);
+		return;
+	}
+	if (following_.load())
+		observe_motion(person_, *person);
+	person_             = *person;
+	detected_keypoints_ = confident_keypoints(*person);
+	gray.copyTo(previous_);
+	confidence_.store(1.0);
+	following_.store(detected_keypoints_ > 0);
+}
+
+void KeypointTracker::detected_late(const PoseModel::PoseDetection& person, const cv::Mat& gray)
+{
+	if (previous_.empty() || gray.size() != previous_.size())
+		return;
+	auto carried        = person;
+	detected_keypoints_ = confident_keypoints(person);
+	if (propagate(gray, previous_, carried))
+	{
+		person_ = carried;
+		following_.store(true);
+	}
+}
+
+optional<PoseModel::PoseDetection> KeypointTracker::track(const cv::Mat& gray)
+{
+	tracked_.fetch_add(1, memory_order_relaxed);
+	if (!following_.load() || previous_.empty() || gray.size() != previous_.size())
+	{
+		following_.store(false);
+		return nullopt;
+	}
+	auto person     = person_;
+	const bool kept = propagate(previous_, gray, person);
+	gray.copyTo(previous_); // Kept even when the track is lost, a late detection is carried forward onto it
+	if (!kept)
+	{
+		following_.store(false);
+		return nullopt;
+	}
+	observe_motion(person_, person);
+	person_ = person;
+	return person;
+}
+
+bool KeypointTracker::propagate(const cv::Mat& from, const cv::Mat& to, PoseModel::PoseDetection& person)
+{
+	thread_local vector<cv::Point2f> points, forward, backward;
+	thread_local vector<uint8_t> status, back_status;
+	thread_local vector<float> error;
+	array<int, PoseModel::KEYPOINT_COUNT> joints{};
+
+	points.clear();
+	for (int k = 0; k < PoseModel::KEYPOINT_COUNT; ++k)
+	{
+		if (person.confidence[k] < PoseModel::KEYPOINT_THRESHOLD)
+			continue;
+		joints[points.size()] = k;
+		points.push_back(person.keypoints[k]);
+	}
+	if (points.empty() || detected_keypoints_ <= 0)
+	{
+		confidence_.store(0.0);
+		return false;
+	}
+
+	// Tracked forward, then back again: a keypoint that does not return to where it started has drifted
+	const cv::Size window(config_.window, config_.window);
+	cv::calcOpticalFlowPyrLK(from, to, points, forward, status, error, window, config_.pyramid_levels);
+	cv::calcOpticalFlowPyrLK(to, from, forward, backward, back_status, error, window, config_.pyramid_levels);
+
+	// Extent of the followed keypoints before and after, the box is mapped along with it
+	int followed = 0;
+	cv::Point2f before_min(FLT_MAX, FLT_MAX), before_max(-FLT_MAX, -FLT_MAX);
+	cv::Point2f after_min(FLT_MAX, FLT_MAX), after_max(-FLT_MAX, -FLT_MAX);
+	for (size_t i = 0; i < points.size(); ++i)
+	{
+		const int k            = joints[i];
+		const float round_trip = hypot(backward[i].x - points[i].x, backward[i].y - points[i].y);
+		if (!status[i] || !back_status[i] || round_trip > config_.max_round_trip)
+		{
+			person.confidence[k] = 0.0f;
+			continue;
+		}
+		before_min = {min(before_min.x, points[i].x), min(before_min.y, points[i].y)};
+		before_max = {max(before_max.x, points[i].x), max(before_max.y, points[i].y)};
+		after_min  = {min(after_min.x, forward[i].x), min(after_min.y, forward[i].y)};
+		after_max  = {max(after_max.x, forward[i].x), max(after_max.y, forward[i].y)};
+		person.keypoints[k] = forward[i];
+		++followed;
+	}
+
+	const double confidence = static_cast<double>(followed) / detected_keypoints_;
+	confidence_.store(confidence);
+	if (followed == 0)
+		return false;
+
+	// Scaled only along an axis the keypoints span well, so a falling body's box turns wide like a detected one would
+	const auto scale = [](const float before, const float after, const float box)
+	{ return before >= 0.25f * box && before >= 1.0f ? after / before : 1.0f; };
+	const float scale_x = scale(before_max.x - before_min.x, after_max.x - after_min.x, person.box.width);
+	const float scale_y = scale(before_max.y - before_min.y, after_max.y - after_min.y, person.box.height);
+	person.box.x        = after_min.x + (person.box.x - before_min.x) * scale_x;
+	person.box.y        = after_min.y + (person.box.y - before_min.y) * scale_y;
+	person.box.width *= scale_x;
+	person.box.height *= scale_y;
+	return confidence >= config_.min_confidence;
+}
+
+void KeypointTracker::observe_motion(const PoseModel::PoseDetection& before, const PoseModel::PoseDetection& after)
+{
+	double moved = 0.0;
+	int joints   = 0;
+	for (int k = 0; k < PoseModel::KEYPOINT_COUNT; ++k)
+	{
+		if (before.confidence[k] < PoseModel::KEYPOINT_THRESHOLD || after.confidence[k] < PoseModel::KEYPOINT_THRESHOLD)
+			continue;
+		moved += hypot(after.keypoints[k].x - before.keypoints[k].x, after.keypoints[k].y - before.keypoints[k].y);
+		++joints;
+	}
+	if (joints == 0 || after.box.height <= 0.0f)
+		return;
+	const double sample = moved / joints / after.box.height;
+	motion_.store(motion() + MOTION_SMOOTHING * (sample - motion()));
+}
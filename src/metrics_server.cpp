@@ -0,0 +1,111 @@
+#include "server/metrics_server.hpp"
+#include "utils/logging_utils.hpp"
+#include "utils/metrics.hpp"
+#include <boost/asio/post.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <fmt/core.h>
+
+using namespace std;
+using namespace boost::asio;
+namespace http = boost::beast::http;
+
+namespace
+{
+constexpr std::string_view TAG = "MetricsServer";
+constexpr auto CONSOLE_COLOR   = Logger::ConsoleColor::GRAY;
+
+constexpr auto REQUEST_TIMEOUT = std::chrono::seconds(5);
+
+// State of one scrape, kept alive by the handlers
+struct Exchange
+{
+	explicit Exchange(ip::tcp::socket socket) : stream(std::move(socket))
+	{
+	}
+
+	boost::beast::tcp_stream stream;
+	boost::beast::flat_buffer buffer;
+	http::request<http::empty_body> request;
+	http::response<http::string_body> response;
+};
+
+void serve(const shared_ptr<Exchange>& exchange)
+{
+	exchange->stream.expires_after(REQUEST_TIMEOUT);
+	http::async_read(exchange->stream, exchange->buffer, exchange->request,
+	                 [exchange](const boost::system::error_code& ec, const size_t)
+	                 {
+		                 if (ec)
+			                 return;
+
+		                 const auto& request = exchange->request;
+		                 auto& response      = exchange->response;
+		                 response.version(request.version());
+		                 response.keep_alive(false);
+		                 if (request.method() != http::verb::get || request.target() != "/metrics")
+		                 {
+			                 response.result(http::status::not_found);
+			                 response.body() = "Not Found\n";
+		                 }
+		                 else
+		                 {
+			                 response.result(http::status::ok);
+			                 response.set(http::field::content_type, "text/plain; version=0.0.4");
+			                 response.body() = Metrics::registry().render();
+		                 }
+		                 response.prepare_payload();
+		                 http::async_write(exchange->stream, response,
+		                                   [exchange](const boost::system::error_code&, const size_t)
+		                                   {
+			                                   boost::system::error_code ignored;
+			                                   exchange->stream.socket().shutdown(ip::tcp::socket::shutdown_both,
+			                                                                      ignored);
+		                                   });
+	                 });
+}
+} // namespace
+
+MetricsServer::MetricsServer(io_context& io_context, const unsigned short port)
+    : acceptor_(io_context, ip::tcp::endpoint(ip::address_v4::loopback(), port))
+{
+}
+
+void MetricsServer::start()
+{
+	do_accept();
+	Logger::info(TAG, CONSOLE_COLOR, "Serving metrics on http://127.0.0.1:{}/metrics",
+	             acceptor_.local_endpoint().port());
+}
+
+void MetricsServer::stop()
+{
+	post(acceptor_.get_executor(),
+	     [self = shared_from_this()]()
+	     {
+		     boost::system::error_code ec;
+		     self->acceptor_.close(ec);
+	     });
+}
+
+void MetricsServer::do_accept()
+{
+	acceptor_.async_accept(
+	    [self = shared_from_this()](const boost::system::error_code& ec, ip::tcp::socket socket)
+	    {
+		    if (ec)
+		    {
+			    if (ec != error::operation_aborted)
+			    {
+				    Logger::error(TAG, "[Accept] Error: {} ({})", ec.message(), ec.value());
+			    }
+			    if (!self->acceptor_.is_open())
+				    return;
+		    }
+		    else
+		    {
+			    serve(make_shared<Exchange>(std::move(socket)));
+		    }
+		    self->do_accept();
+	    });
+}
@@ -0,0 +1,106 @@
+#include "vision/motion_gate.hpp"
+#include "utils/cpu_features.hpp"
+#include <algorithm>
+#include <bit>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+#if defined(SOLICARE_AVX2_KERNELS)
+// Counts over the leading multiple of 32 pixels, processed is set to how many that were
+SOLICARE_TARGET_AVX2 size_t count_changed_avx2(const uint8_t* first, const uint8_t* second, const size_t count,
+                                               const uint8_t limit, size_t& processed)
+{
+	// |a - b| > limit  <=>  max(a, b) - min(a, b) saturated by limit is not zero
+	const __m256i limits = _mm256_set1_epi8(static_cast<char>(limit));
+	const __m256i zero   = _mm256_setzero_si256();
+	size_t changed       = 0;
+	size_t i             = 0;
+	for (; i + 32 <= count; i += 32)
+	{
+		const __m256i a          = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + i));
+		const __m256i b          = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + i));
+		const __m256i difference = _mm256_sub_epi8(_mm256_max_epu8(a, b), _mm256_min_epu8(a, b));
+		const __m256i above      = _mm256_subs_epu8(difference, limits);
+		const auto unchanged     = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(above, zero)));
+		changed += 32 - static_cast<size_t>(popcount(unchanged));
+	}
+	processed = i;
+	return changed;
+}
+#endif
+} // namespace
+
+size_t count_changed_pixels(const uint8_t* first, const uint8_t* second, const size_t count, const int threshold)
+{
+	const auto limit = static_cast<uint8_t>(std::clamp(threshold, 0, 255));
+	size_t changed   = 0;
+	size_t i         = 0;
+#if defined(SOLICARE_AVX2_KERNELS)
+	if (CpuFeatures::has_avx2())
+		changed = count_changed_avx2(first, second, count, limit, i);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	const uint8x16_t limits = vdupq_n_u8(limit);
+	for (; i + 16 <= count; i += 16)
+	{
+		const uint8x16_t above = vcgtq_u8(vabdq_u8(vld1q_u8(first + i), vld1q_u8(second + i)), limits);
+		changed += vaddvq_u8(vshrq_n_u8(above, 7)); // 0xFF -> 1, at most 16
+	}
+#endif
+	for (; i < count; ++i)
+		changed += abs(static_cast<int>(first[i]) - static_cast<int>(second[i])) > limit ? 1 : 0;
+	return changed;
+}
+
+void MotionGate::configure(const MotionGateConfig& config)
+{
+	const lock_guard lock(mutex_);
+	config_ = config;
+	reference_.release();
+}
+
+MotionGate::Decision MotionGate::evaluate(const cv::Mat& frame, const Clock::time_point now)
+{
+	evaluated_.fetch_add(1, memory_order_relaxed);
+	if (!config_.enabled)
+		return {true, 1.0};
+
+	// Shrunk before the color conversion, INTER_AREA averages out sensor noise and is cheap at integer ratios
+	thread_local cv::Mat small, gray;
+	const int width  = min(config_.width, frame.cols);
+	const int height = max(1, frame.rows * width / frame.cols);
+	cv::resize(frame, small, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+	cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+
+	const lock_guard lock(mutex_);
+	double motion = 1.0;
+	if (reference_.size() == gray.size() && gray.isContinuous() && reference_.isContinuous())
+	{
+		const size_t changed =
+		    count_changed_pixels(gray.ptr<uint8_t>(), reference_.ptr<uint8_t>(), gray.total(), config_.pixel_threshold);
+		motion = static_cast<double>(changed) / static_cast<double>(gray.total());
+	}
+	if (motion >= config_.motion_threshold)
+		last_motion_ = now;
+
+	const bool infer = now - last_motion_ < config_.hold || now - last_inference_ >= config_.heartbeat;
+	if (!infer)
+	{
+		skipped_.fetch_add(1, memory_order_relaxed);
+		return {false, motion};
+	}
+	last_inference_ = now;
+	gray.copyTo(reference_);
+	return {true, motion};
+}
+
+double MotionGate::skip_ratio() const
+{
+	const auto frames = evaluated();
+	return frames ? static_cast<double>(skipped()) / static_cast<double>(frames) : 0.0;
+}
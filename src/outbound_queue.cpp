@@ -0,0 +1,107 @@
+#include "server/outbound_queue.hpp"
+#include "utils/logging_utils.hpp"
+#include <algorithm>
+#include <boost/asio/post.hpp>
+#include <fmt/core.h>
+
+using namespace std;
+
+namespace
+{
+constexpr std::string_view TAG = "OutboundQueue";
+} // namespace
+
+OutboundQueue::OutboundQueue(const shared_ptr<WebSocket>& ws, const size_t max_queued_bytes)
+    : ws_(ws), max_queued_bytes_(max_queued_bytes)
+{
+}
+
+bool OutboundQueue::send(string payload, const bool text, string coalesce_key)
+{
+	const auto size = payload.size();
+	auto queued     = queued_bytes_.load(memory_order_relaxed);
+	do
+	{
+		if (queued + size > max_queued_bytes_)
+		{
+			rejected_.fetch_add(1, memory_order_relaxed);
+			return false;
+		}
+	} while (!queued_bytes_.compare_exchange_weak(queued, queued + size, memory_order_relaxed));
+
+	auto message = Message{std::move(payload), text, std::move(coalesce_key)};
+	boost::asio::post(ws_->get_executor(), [self = shared_from_this(), message = std::move(message)]() mutable
+	                  { self->enqueue(std::move(message)); });
+	return true;
+}
+
+size_t OutboundQueue::queued_bytes() const
+{
+	return queued_bytes_.load(memory_order_relaxed);
+}
+
+uint64_t OutboundQueue::rejected() const
+{
+	return rejected_.load(memory_order_relaxed);
+}
+
+void OutboundQueue::enqueue(Message message)
+{
+	if (!message.coalesce_key.empty())
+	{
+		// Never touch the front while it is being written
+		const auto first = queue_.begin() + (writing_ ? 1 : 0);
+		if (const auto it = find_if(first, queue_.end(),
+		                            [&](const Message& queued) { return queued.coalesce_key == message.coalesce_key; });
+		    it != queue_.end())
+		{
+			queued_bytes_.fetch_sub(it->payload.size(), memory_order_relaxed);
+			*it = std::move(message);
+			return;
+		}
+	}
+	queue_.push_back(std::move(message));
+	if (!writing_)
+	{
+		do_write();
+	}
+}
+
+void OutboundQueue::do_write()
+{
+	if (!ws_->is_open())
+	{
+		// Nothing will be written anymore, give the budget back
+		for (const auto& message : queue_)
+		{
+			queued_bytes_.fetch_sub(message.payload.size(), memory_order_relaxed);
+		}
+		queue_.clear();
+	}
+	if (queue_.empty())
+	{
+		writing_ = false;
+		return;
+	}
+	writing_ = true;
+	ws_->text(queue_.front().text);
+	ws_->async_write(boost::asio::buffer(queue_.front().payload),
+	                 [self = shared_from_this()](const boost::system::error_code& ec, const size_t)
+	                 {
+		                 self->queued_bytes_.fetch_sub(self->queue_.front().payload.size(), memory_order_relaxed);
+		                 self->queue_.pop_front();
+		                 if (ec)
+		                 {
+			                 // The read loop notices the broken connection as well, drop whatever is left
+			                 Logger::error(TAG, "[Write] Error: {} ({})", ec.message(), ec.value());
+			                 for (const auto& message : self->queue_)
+			                 {
+				                 self->queued_bytes_.fetch_sub(message.payload.size(), memory_order_relaxed);
+			                 }
+			                 self->queue_.clear();
+			                 self->writing_ = false;
+			                 return;
+		                 }
+		                 self->do_write();
+	                 });
+}
@@ -0,0 +1,57 @@
+#include "vision/person_follower.hpp"
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+float intersection_over_union(const cv::Rect2f& a, const cv::Rect2f& b)
+{
+	const float intersection = (a & b).area();
+	const float united       = a.area() + b.area() - intersection;
+	return united > 0.0f ? intersection / united : 0.0f;
+}
+} // namespace
+
+int PersonFollower::select(const PoseDecoder::PoseDetections& people)
+{
+	switched_ = false;
+	if (const int index = match(people); index >= 0)
+	{
+		follow(people.items[index]);
+		return index;
+	}
+	if (box_ && ++missed_ <= config_.max_missed)
+		return -1; // Likely occluded or missed by the detector for a moment, nobody else is followed yet
+	if (people.empty())
+	{
+		box_ = nullopt;
+		return -1;
+	}
+	follow(people.front()); // Highest score first
+	switched_ = true;
+	return 0;
+}
+
+int PersonFollower::match(const PoseDecoder::PoseDetections& people) const
+{
+	if (!box_)
+		return -1;
+	int best       = -1;
+	float best_iou = config_.min_iou;
+	for (int i = 0; i < people.count; ++i)
+	{
+		if (const float iou = intersection_over_union(*box_, people.items[i].box); iou >= best_iou)
+		{
+			best     = i;
+			best_iou = iou;
+		}
+	}
+	return best;
+}
+
+void PersonFollower::follow(const PoseModel::PoseDetection& person)
+{
+	box_    = person.box;
+	missed_ = 0;
+}
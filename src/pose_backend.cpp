@@ -0,0 +1,211 @@
+#include "vision/pose_backend.hpp"
+#include "vision/pose_model.hpp"
+#include <array>
+#include <fmt/core.h>
+#include <opencv2/dnn.hpp>
+#include <stdexcept>
+
+#ifdef SOLICARE_WITH_ONNXRUNTIME
+#include <onnxruntime_cxx_api.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+constexpr std::array<std::pair<POSE_BACKEND, std::string_view>, 5> BACKEND_NAMES = {{
+    {BACKEND_AUTO, "auto"},
+    {BACKEND_OPENCV_CPU, "opencv"},
+    {BACKEND_OPENCV_CUDA, "opencv-cuda"},
+    {BACKEND_OPENVINO, "openvino"},
+    {BACKEND_ONNXRUNTIME, "onnxruntime"},
+}};
+
+constexpr std::array<std::pair<POSE_PRECISION, std::string_view>, 2> PRECISION_NAMES = {{
+    {PRECISION_FP32, "fp32"},
+    {PRECISION_INT8, "int8"},
+}};
+
+bool opencv_has_backend(const int backend)
+{
+	for (const auto& [available_backend, target] : cv::dnn::getAvailableBackends())
+	{
+		if (available_backend == backend)
+			return true;
+	}
+	return false;
+}
+
+class OpenCVPoseBackend final : public PoseBackend
+{
+  public:
+	OpenCVPoseBackend(const PoseBackendConfig& config, const int backend, const int target)
+	    : net_(cv::dnn::readNetFromONNX(config.model_path())),
+	      name_(fmt::format("{}/{}", to_string(config.backend), to_string(config.precision)))
+	{
+		net_.setPreferableBackend(backend);
+		net_.setPreferableTarget(target);
+	}
+
+	[[nodiscard]] std::string name() const override
+	{
+		return name_;
+	}
+
+	cv::Mat forward(const cv::Mat& blob) override
+	{
+		net_.setInput(blob);
+		// The net's output blob is overwritten in place by the next forward() of the same shape, while the decoders
+		// of this batch may still read it
+		return net_.forward().clone();
+	}
+
+  private:
+	cv::dnn::Net net_;
+	const std::string name_;
+};
+
+#ifdef SOLICARE_WITH_ONNXRUNTIME
+class OnnxRuntimePoseBackend final : public PoseBackend
+{
+  public:
+	explicit OnnxRuntimePoseBackend(const PoseBackendConfig& config)
+	    : env_(ORT_LOGGING_LEVEL_WARNING, "solicare_pose"), session_(nullptr),
+	      memory_info_(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)),
+	      name_(fmt::format("{}/{}", to_string(config.backend), to_string(config.precision)))
+	{
+		Ort::SessionOptions options;
+		options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+		if (config.threads > 0)
+			options.SetIntraOpNumThreads(config.threads);
+		const auto& path = config.model_path();
+#ifdef _WIN32
+		const std::wstring model_path(path.begin(), path.end());
+		session_ = Ort::Session(env_, model_path.c_str(), options);
+#else
+		session_ = Ort::Session(env_, path.c_str(), options);
+#endif
+		Ort::AllocatorWithDefaultOptions allocator;
+		input_name_  = session_.GetInputNameAllocated(0, allocator).get();
+		output_name_ = session_.GetOutputNameAllocated(0, allocator).get();
+	}
+
+	[[nodiscard]] std::string name() const override
+	{
+		return name_;
+	}
+
+	// The output is written straight into the returned cv::Mat, its shape follows from the input size
+	cv::Mat forward(const cv::Mat& blob) override
+	{
+		const std::array<int64_t, 4> input_shape  = {blob.size[0], blob.size[1], blob.size[2], blob.size[3]};
+		const std::array<int, 3> output_dims      = {blob.size[0], PoseModel::OUTPUT_CHANNELS,
+		                                             PoseModel::anchor_count(blob.size[2])};
+		const std::array<int64_t, 3> output_shape = {output_dims[0], output_dims[1], output_dims[2]};
+		cv::Mat output(3, output_dims.data(), CV_32F);
+
+		auto input = Ort::Value::CreateTensor<float>(memory_info_, const_cast<float*>(blob.ptr<float>()),
+		                                             blob.total(), input_shape.data(), input_shape.size());
+		auto result = Ort::Value::CreateTensor<float>(memory_info_, output.ptr<float>(), output.total(),
+		                                              output_shape.data(), output_shape.size());
+		const char* input_names[]  = {input_name_.c_str()};
+		const char* output_names[] = {output_name_.c_str()};
+		session_.Run(Ort::RunOptions{nullptr}, input_names, &input, 1, output_names, &result, 1);
+		return output;
+	}
+
+  private:
+	Ort::Env env_;
+	Ort::Session session_;
+	Ort::MemoryInfo memory_info_;
+	std::string input_name_;
+	std::string output_name_;
+	const std::string name_;
+};
+#endif
+} // namespace
+
+std::unique_ptr<PoseBackend> make_pose_backend(const PoseBackendConfig& config)
+{
+	if (!is_pose_backend_available(config.backend))
+		throw std::runtime_error(
+		    fmt::format("pose backend {} is not available in this build", to_string(config.backend)));
+
+	switch (config.backend)
+	{
+	case BACKEND_OPENCV_CPU:
+		return std::make_unique<OpenCVPoseBackend>(config, cv::dnn::DNN_BACKEND_OPENCV, cv::dnn::DNN_TARGET_CPU);
+	case BACKEND_OPENCV_CUDA:
+		return std::make_unique<OpenCVPoseBackend>(config, cv::dnn::DNN_BACKEND_CUDA, cv::dnn::DNN_TARGET_CUDA);
+	case BACKEND_OPENVINO:
+		return std::make_unique<OpenCVPoseBackend>(config, cv::dnn::DNN_BACKEND_INFERENCE_ENGINE,
+		                                           cv::dnn::DNN_TARGET_CPU);
+#ifdef SOLICARE_WITH_ONNXRUNTIME
+	case BACKEND_ONNXRUNTIME:
+		return std::make_unique<OnnxRuntimePoseBackend>(config);
+#endif
+	default:
+		throw std::runtime_error(fmt::format("pose backend {} has to be resolved first", to_string(config.backend)));
+	}
+}
+
+bool is_pose_backend_available(const POSE_BACKEND backend)
+{
+	switch (backend)
+	{
+	case BACKEND_OPENCV_CPU:
+		return true;
+	case BACKEND_OPENCV_CUDA:
+		return opencv_has_backend(cv::dnn::DNN_BACKEND_CUDA);
+	case BACKEND_OPENVINO:
+		return opencv_has_backend(cv::dnn::DNN_BACKEND_INFERENCE_ENGINE);
+	case BACKEND_ONNXRUNTIME:
+#ifdef SOLICARE_WITH_ONNXRUNTIME
+		return true;
+#else
+		return false;
+#endif
+	default:
+		return false;
+	}
+}
+
+std::string_view to_string(const POSE_BACKEND backend)
+{
+	for (const auto& [value, name] : BACKEND_NAMES)
+	{
+		if (value == backend)
+			return name;
+	}
+	return "unknown";
+}
+
+std::string_view to_string(const POSE_PRECISION precision)
+{
+	for (const auto& [value, name] : PRECISION_NAMES)
+	{
+		if (value == precision)
+			return name;
+	}
+	return "unknown";
+}
+
+std::optional<POSE_BACKEND> parse_pose_backend(const std::string_view name)
+{
+	for (const auto& [value, value_name] : BACKEND_NAMES)
+	{
+		if (value_name == name)
+			return value;
+	}
+	return std::nullopt;
+}
+
+std::optional<POSE_PRECISION> parse_pose_precision(const std::string_view name)
+{
+	for (const auto& [value, value_name] : PRECISION_NAMES)
+	{
+		if (value_name == name)
+			return value;
+	}
+	return std::nullopt;
+}
@@ -0,0 +1,146 @@
+#include "vision/pose_decoder.hpp"
+#include "utils/cpu_features.hpp"
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+struct Candidate
+{
+	int anchor;
+	float score;
+	float x1, y1, x2, y2; // Model input pixels
+	float area;
+};
+
+#if defined(SOLICARE_AVX2_KERNELS)
+// Scans the leading multiple of 8 anchors, returns how many were scanned
+SOLICARE_TARGET_AVX2 int scan_scores_avx2(const float* scores, const int count, const float threshold,
+                                          vector<int>& anchors)
+{
+	const __m256 limit = _mm256_set1_ps(threshold);
+	int anchor         = 0;
+	for (; anchor + 8 <= count; anchor += 8)
+	{
+		auto mask = static_cast<unsigned>(
+		    _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(scores + anchor), limit, _CMP_GT_OQ)));
+		for (; mask != 0; mask &= mask - 1)
+			anchors.push_back(anchor + countr_zero(mask));
+	}
+	return anchor;
+}
+#endif
+
+// Appends the anchors whose score is above threshold, in anchor order
+void scan_scores(const float* scores, const int count, const float threshold, vector<int>& anchors)
+{
+	int anchor = 0;
+#if defined(SOLICARE_AVX2_KERNELS)
+	if (CpuFeatures::has_avx2())
+		anchor = scan_scores_avx2(scores, count, threshold, anchors);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	const float32x4_t limit = vdupq_n_f32(threshold);
+	for (; anchor + 4 <= count; anchor += 4)
+	{
+		// Almost every group is below the threshold, only the rare hits are resolved lane by lane
+		if (vmaxvq_u32(vcgtq_f32(vld1q_f32(scores + anchor), limit)) == 0)
+			continue;
+		for (int lane = anchor; lane < anchor + 4; ++lane)
+		{
+			if (scores[lane] > threshold)
+				anchors.push_back(lane);
+		}
+	}
+#endif
+	for (; anchor < count; ++anchor)
+	{
+		if (scores[anchor] > threshold)
+			anchors.push_back(anchor);
+	}
+}
+
+float intersection_over_union(const Candidate& a, const Candidate& b)
+{
+	const float width  = min(a.x2, b.x2) - max(a.x1, b.x1);
+	const float height = min(a.y2, b.y2) - max(a.y1, b.y1);
+	if (width <= 0.0f || height <= 0.0f)
+		return 0.0f;
+	const float intersection = width * height;
+	return intersection / (a.area + b.area - intersection);
+}
+} // namespace
+
+void PoseDecoder::decode(const cv::Mat& output, const PoseModel::Letterbox& letterbox, PoseDetections& detections,
+                         const float score_threshold, const float iou_threshold)
+{
+	detections.count   = 0;
+	const auto* data   = output.ptr<float>();
+	const int channels = output.dims == 3 ? output.size[1] : output.rows;
+	const int anchors  = output.dims == 3 ? output.size[2] : output.cols;
+	if (data == nullptr || !output.isContinuous() || channels != PoseModel::OUTPUT_CHANNELS || anchors <= 0)
+		return;
+	const auto channel = [data, anchors](const int c, const int anchor) { return data[c * anchors + anchor]; };
+
+	thread_local vector<int> hits;
+	thread_local vector<Candidate> candidates;
+	hits.clear();
+	candidates.clear();
+	scan_scores(data + 4 * anchors, anchors, score_threshold, hits);
+	if (hits.empty())
+		return;
+
+	for (const int anchor : hits)
+	{
+		const float half_width  = channel(2, anchor) / 2;
+		const float half_height = channel(3, anchor) / 2;
+		candidates.push_back({anchor, channel(4, anchor), channel(0, anchor) - half_width,
+		                      channel(1, anchor) - half_height, channel(0, anchor) + half_width,
+		                      channel(1, anchor) + half_height, 4 * half_width * half_height});
+	}
+	const auto by_score = [](const Candidate& a, const Candidate& b) { return a.score > b.score; };
+	if (candidates.size() > static_cast<size_t>(MAX_CANDIDATES))
+	{
+		ranges::nth_element(candidates, candidates.begin() + MAX_CANDIDATES, by_score);
+		candidates.resize(MAX_CANDIDATES);
+	}
+	ranges::sort(candidates, by_score);
+
+	// Greedy NMS against the people kept so far, at most MAX_DETECTIONS comparisons per candidate
+	array<const Candidate*, MAX_DETECTIONS> kept{};
+	int kept_count = 0;
+	for (const auto& candidate : candidates)
+	{
+		const bool duplicate = any_of(kept.begin(), kept.begin() + kept_count, [&](const Candidate* better)
+		                              { return intersection_over_union(*better, candidate) > iou_threshold; });
+		if (duplicate)
+			continue;
+		kept[kept_count++] = &candidate;
+		if (kept_count == MAX_DETECTIONS)
+			break;
+	}
+
+	for (int i = 0; i < kept_count; ++i)
+	{
+		const auto& candidate   = *kept[i];
+		auto& detection         = detections.items[i];
+		const auto top_left     = letterbox.to_frame(candidate.x1, candidate.y1);
+		const auto bottom_right = letterbox.to_frame(candidate.x2, candidate.y2);
+		detection.score = candidate.score;
+		detection.box   = cv::Rect2f(top_left.x, top_left.y, bottom_right.x - top_left.x, bottom_right.y - top_left.y);
+		for (int k = 0; k < PoseModel::KEYPOINT_COUNT; ++k)
+		{
+			const int c             = PoseModel::BOX_CHANNELS + k * 3;
+			const int anchor        = candidate.anchor;
+			detection.keypoints[k]  = letterbox.to_frame(channel(c, anchor), channel(c + 1, anchor));
+			detection.confidence[k] = channel(c + 2, anchor);
+		}
+	}
+	detections.count = kept_count;
+}
@@ -0,0 +1,198 @@
+#include "vision/pose_inference_service.hpp"
+#include "utils/logging_utils.hpp"
+#include "utils/metrics.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace chrono;
+
+namespace
+{
+constexpr std::string_view TAG = "PoseInferenceService";
+} // namespace
+
+cv::Mat PoseInferenceService::Result::output() const
+{
+	if (batch_output.dims != 3)
+		return batch_output;
+	return {batch_output.size[1], batch_output.size[2], CV_32F,
+	        const_cast<float*>(batch_output.ptr<float>(index))};
+}
+
+PoseInferenceService::PoseInferenceService(PoseBackend& backend, const size_t max_batch_size,
+                                           const microseconds max_batch_delay)
+    : backend_(backend), configured_batch_size_(max<size_t>(1, max_batch_size)),
+      max_batch_size_(configured_batch_size_), max_batch_delay_(max_batch_delay)
+{
+	thread_ = thread([this] { run(); });
+}
+
+PoseInferenceService::~PoseInferenceService()
+{
+	{
+		lock_guard lock(mutex_);
+		stopping_ = true;
+	}
+	requested_.notify_one();
+	if (thread_.joinable())
+		thread_.join();
+}
+
+void PoseInferenceService::add_backend(const int input_size, PoseBackend& backend)
+{
+	sized_backends_.emplace_back(input_size, &backend);
+}
+
+void PoseInferenceService::submit(cv::Mat tensor, Completion completion)
+{
+	bool wake;
+	{
+		lock_guard lock(mutex_);
+		pending_.push_back({std::move(tensor), std::move(completion), steady_clock::now()});
+		// The first request starts the batch deadline, a full batch is flushed right away
+		wake = pending_.size() == 1 || pending_.size() >= max_batch_size_;
+	}
+	if (wake)
+		requested_.notify_one();
+}
+
+void PoseInferenceService::run()
+{
+	vector<Request> batch;
+	unique_lock lock(mutex_);
+	while (true)
+	{
+		requested_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+		if (pending_.empty())
+			return; // Stopping and drained
+
+		const auto deadline = pending_.front().submitted + max_batch_delay_;
+		requested_.wait_until(lock, deadline, [this] { return stopping_ || pending_.size() >= max_batch_size_; });
+
+		// Only inputs of one size share a forward(), full frames and crops are batched separately
+		const int height     = pending_.front().tensor.size[2];
+		const int width      = pending_.front().tensor.size[3];
+		const auto same_size = [height, width](const Request& request)
+		{ return request.tensor.size[2] == height && request.tensor.size[3] == width; };
+		const auto matching  = stable_partition(pending_.begin(), pending_.end(), same_size);
+		const auto count     = min(matching - pending_.begin(), static_cast<ptrdiff_t>(max_batch_size_));
+		batch.assign(make_move_iterator(pending_.begin()), make_move_iterator(pending_.begin() + count));
+		pending_.erase(pending_.begin(), pending_.begin() + count);
+
+		lock.unlock();
+		const auto started = steady_clock::now();
+		infer(batch);
+		record_busy(started, steady_clock::now());
+		batch.clear();
+		lock.lock();
+	}
+}
+
+void PoseInferenceService::record_busy(const steady_clock::time_point started, const steady_clock::time_point finished)
+{
+	constexpr double SMOOTHING = 0.1; // Weight of the newest batch
+	// One cycle is the idle wait before the batch plus its processing
+	const auto cycle = finished - (last_finished_ == steady_clock::time_point{} ? started : last_finished_);
+	last_finished_   = finished;
+	if (cycle <= steady_clock::duration::zero())
+		return;
+	const double busy    = duration<double>(finished - started) / cycle;
+	const double current = utilization_.load(memory_order_relaxed);
+	utilization_.store(current + SMOOTHING * (busy - current), memory_order_relaxed);
+}
+
+cv::Mat PoseInferenceService::pack(const vector<Request>& batch)
+{
+	// The inputs are already preprocessed, a single one is forwarded as is
+	const cv::Mat& first = batch.front().tensor;
+	if (batch.size() == 1)
+		return first;
+
+	const int dims[] = {static_cast<int>(batch.size()), first.size[1], first.size[2], first.size[3]};
+	batch_tensor_.create(4, dims, CV_32F);
+	const size_t item_bytes = first.total() * first.elemSize();
+	for (size_t i = 0; i < batch.size(); ++i)
+	{
+		const cv::Mat& tensor = batch[i].tensor;
+		if (tensor.total() * tensor.elemSize() != item_bytes)
+			throw std::invalid_argument("inputs of different shapes in one batch");
+		memcpy(batch_tensor_.ptr<float>(static_cast<int>(i)), tensor.ptr<float>(), item_bytes);
+	}
+	return batch_tensor_;
+}
+
+bool PoseInferenceService::infer(vector<Request>& batch)
+{
+	static auto& batch_size = Metrics::registry().histogram(
+	    "solicare_pose_batch_size", "Frames per pose model forward()", {}, {1, 2, 3, 4, 6, 8, 12, 16});
+	static auto& forward_seconds =
+	    Metrics::registry().histogram("solicare_pose_forward_seconds", "Duration of one batched pose model forward()");
+
+	PoseBackend& backend = backend_for(batch.front().tensor);
+	cv::Mat output;
+	string error;
+	try
+	{
+		const cv::Mat blob = pack(batch);
+		const Metrics::ScopedTimer forward_timer(forward_seconds);
+		output = backend.forward(blob);
+		if (output.dims != 3 || output.size[0] != static_cast<int>(batch.size()))
+			error = fmt::format("unexpected output shape for a batch of {}", batch.size());
+	}
+	catch (const std::exception& e) // cv::Exception, Ort::Exception
+	{
+		error = e.what();
+	}
+
+	if (!error.empty() && batch.size() > 1)
+	{
+		const size_t frames = batch.size();
+		size_t served       = 0;
+		for (auto& request : batch)
+		{
+			vector<Request> single;
+			single.push_back(std::move(request));
+			served += infer(single) ? 1 : 0;
+		}
+		if (served < frames)
+		{
+			Logger::warn(TAG, "Batched forward() of {} frames failed, single frames failed too: {}", frames, error);
+			return false;
+		}
+		// Only batches fail, most likely a model exported with a static batch dimension
+		Logger::warn(TAG, "Batched forward() of {} frames failed, single frames succeed, running single-frame "
+		                  "inference for the next {} frames: {}",
+		             frames, BATCH_RETRY_FRAMES, error);
+		const lock_guard lock(mutex_);
+		max_batch_size_     = 1;
+		single_frames_left_ = BATCH_RETRY_FRAMES;
+		return true;
+	}
+	if (error.empty())
+		batch_size.observe(static_cast<double>(batch.size()));
+	else
+		Logger::error(TAG, "[{}] forward() error: {}", backend.name(), error);
+
+	for (size_t i = 0; i < batch.size(); ++i)
+		batch[i].completion({error.empty() ? output : cv::Mat(), static_cast<int>(i), error});
+
+	if (error.empty() && single_frames_left_ > 0 && --single_frames_left_ == 0 && configured_batch_size_ > 1)
+	{
+		Logger::info(TAG, "Trying batched inference again, up to {} frames per forward()", configured_batch_size_);
+		const lock_guard lock(mutex_);
+		max_batch_size_ = configured_batch_size_;
+	}
+	return error.empty();
+}
+
+PoseBackend& PoseInferenceService::backend_for(const cv::Mat& tensor)
+{
+	for (const auto& [input_size, backend] : sized_backends_)
+	{
+		if (tensor.size[2] == input_size && tensor.size[3] == input_size)
+			return *backend;
+	}
+	return backend_;
+}
@@ -0,0 +1,242 @@
+#include "vision/preprocess.hpp"
+#include "utils/cpu_features.hpp"
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+constexpr float INV_255 = 1.0f / 255.0f;
+
+// Source sampling positions of one axis, same convention as cv::resize(INTER_LINEAR): pixel centres are aligned
+struct AxisMap
+{
+	vector<int> index0; // First source pixel
+	vector<int> index1; // Second source pixel, index0 + 1 except at the border
+	vector<float> weight; // Weight of index1
+};
+
+void build_axis(const int source, const int target, AxisMap& map)
+{
+	map.index0.resize(target);
+	map.index1.resize(target);
+	map.weight.resize(target);
+	const float ratio = static_cast<float>(source) / static_cast<float>(target);
+	for (int i = 0; i < target; ++i)
+	{
+		const float position = std::clamp((static_cast<float>(i) + 0.5f) * ratio - 0.5f, 0.0f,
+		                                  static_cast<float>(source - 1));
+		const int first      = std::min(static_cast<int>(position), source - 1);
+		map.index0[i]        = first;
+		map.index1[i]        = std::min(first + 1, source - 1);
+		map.weight[i]        = position - static_cast<float>(first);
+	}
+}
+
+// One source row resampled horizontally, one float plane per channel in RGB order, not normalized yet
+struct ResampledRow
+{
+	int source_row = -1;
+	vector<float> planes; // 3 * width
+};
+
+// Per-thread scratch space, sized for the largest frame seen so the hot path does not allocate
+struct Scratch
+{
+	int source_width = 0, source_height = 0, width = 0, height = 0;
+	AxisMap columns, rows;
+	vector<int> offset0, offset1; // Byte offsets of the column samples inside a source row
+	int vector_columns = 0;       // Leading columns whose 4-byte loads stay inside the source row
+	array<ResampledRow, 2> cache;
+};
+
+void prepare(Scratch& scratch, const int source_width, const int source_height, const int width, const int height)
+{
+	if (scratch.source_width == source_width && scratch.source_height == source_height && scratch.width == width &&
+	    scratch.height == height)
+		return;
+	scratch.source_width  = source_width;
+	scratch.source_height = source_height;
+	scratch.width         = width;
+	scratch.height        = height;
+	build_axis(source_width, width, scratch.columns);
+	build_axis(source_height, height, scratch.rows);
+
+	scratch.offset0.resize(width);
+	scratch.offset1.resize(width);
+	scratch.vector_columns = 0;
+	for (int x = 0; x < width; ++x)
+	{
+		scratch.offset0[x] = scratch.columns.index0[x] * 3;
+		scratch.offset1[x] = scratch.columns.index1[x] * 3;
+		if (scratch.offset1[x] + 4 <= source_width * 3)
+			scratch.vector_columns = x + 1;
+	}
+	scratch.vector_columns -= scratch.vector_columns % 8;
+	for (auto& row : scratch.cache)
+		row.planes.resize(static_cast<size_t>(width) * 3);
+}
+
+#if defined(SOLICARE_AVX2_KERNELS)
+// Resamples the first vector_columns columns, returns how many were done
+SOLICARE_TARGET_AVX2 int resample_columns_avx2(const uint8_t* source, const Scratch& scratch, float* red,
+                                               float* green, float* blue)
+{
+	// Gathers 4 bytes (B, G, R and one byte of the next pixel) per sample, then splits the channels with shifts
+	const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+	const auto* row         = reinterpret_cast<const int*>(source);
+	int x                   = 0;
+	for (; x < scratch.vector_columns; x += 8)
+	{
+		const __m256i pixel0 = _mm256_i32gather_epi32(
+		    row, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(scratch.offset0.data() + x)), 1);
+		const __m256i pixel1 = _mm256_i32gather_epi32(
+		    row, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(scratch.offset1.data() + x)), 1);
+		const __m256 weight = _mm256_loadu_ps(scratch.columns.weight.data() + x);
+		float* const outputs[3] = {blue, green, red};
+		for (int channel = 0; channel < 3; ++channel)
+		{
+			const __m256i shift = _mm256_set1_epi32(channel * 8);
+			const __m256 first  = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(pixel0, shift), byte_mask));
+			const __m256 second = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(pixel1, shift), byte_mask));
+			_mm256_storeu_ps(outputs[channel] + x, _mm256_fmadd_ps(weight, _mm256_sub_ps(second, first), first));
+		}
+	}
+	return x;
+}
+
+// Blends the leading multiple of 8 elements, returns how many were done
+SOLICARE_TARGET_AVX2 int blend_rows_avx2(const float* top, const float* bottom, const float weight, float* output,
+                                         const int count)
+{
+	const __m256 row_weight = _mm256_set1_ps(weight);
+	const __m256 scale      = _mm256_set1_ps(INV_255);
+	int i                   = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 first  = _mm256_loadu_ps(top + i);
+		const __m256 second = _mm256_loadu_ps(bottom + i);
+		_mm256_storeu_ps(output + i,
+		                 _mm256_mul_ps(_mm256_fmadd_ps(row_weight, _mm256_sub_ps(second, first), first), scale));
+	}
+	return i;
+}
+#endif
+
+void resample_row(const uint8_t* source, const Scratch& scratch, float* red, float* green, float* blue)
+{
+	int x = 0;
+#if defined(SOLICARE_AVX2_KERNELS)
+	if (CpuFeatures::has_avx2())
+		x = resample_columns_avx2(source, scratch, red, green, blue);
+#endif
+	for (; x < scratch.width; ++x)
+	{
+		const uint8_t* first  = source + scratch.offset0[x];
+		const uint8_t* second = source + scratch.offset1[x];
+		const float weight    = scratch.columns.weight[x];
+		blue[x]  = first[0] + weight * static_cast<float>(second[0] - first[0]);
+		green[x] = first[1] + weight * static_cast<float>(second[1] - first[1]);
+		red[x]   = first[2] + weight * static_cast<float>(second[2] - first[2]);
+	}
+}
+
+// output = (top + weight * (bottom - top)) / 255
+void blend_rows(const float* top, const float* bottom, const float weight, float* output, const int count)
+{
+	int i = 0;
+#if defined(SOLICARE_AVX2_KERNELS)
+	if (CpuFeatures::has_avx2())
+		i = blend_rows_avx2(top, bottom, weight, output, count);
+#elif defined(__ARM_NEON)
+	const float32x4_t row_weight = vdupq_n_f32(weight);
+	const float32x4_t scale      = vdupq_n_f32(INV_255);
+	for (; i + 4 <= count; i += 4)
+	{
+		const float32x4_t first  = vld1q_f32(top + i);
+		const float32x4_t second = vld1q_f32(bottom + i);
+		vst1q_f32(output + i, vmulq_f32(vmlaq_f32(first, row_weight, vsubq_f32(second, first)), scale));
+	}
+#endif
+	for (; i < count; ++i)
+		output[i] = (top[i] + weight * (bottom[i] - top[i])) * INV_255;
+}
+
+const ResampledRow& resampled(Scratch& scratch, const uint8_t* frame, const size_t stride, const int source_row,
+                              const int keep_row)
+{
+	for (const auto& row : scratch.cache)
+	{
+		if (row.source_row == source_row)
+			return row;
+	}
+	// Overwrites the cached row that is not needed for the current output row
+	auto& row      = scratch.cache[0].source_row == keep_row ? scratch.cache[1] : scratch.cache[0];
+	row.source_row = source_row;
+	float* planes  = row.planes.data();
+	resample_row(frame + stride * source_row, scratch, planes, planes + scratch.width, planes + 2 * scratch.width);
+	return row;
+}
+} // namespace
+
+PoseModel::Letterbox Preprocess::letterbox_to_tensor(const uint8_t* frame, const int width, const int height,
+                                                     const size_t stride, float* tensor, const int size)
+{
+	cv::Rect content;
+	const auto placement = PoseModel::letterbox_placement(cv::Size(width, height), size, content);
+
+	thread_local Scratch scratch;
+	prepare(scratch, width, height, content.width, content.height);
+	for (auto& row : scratch.cache)
+		row.source_row = -1; // Rows of the previous frame, same size or not
+
+	const auto plane_size = static_cast<size_t>(size) * size;
+	const float padding   = static_cast<float>(PoseModel::PADDING_COLOR) * INV_255;
+	for (int channel = 0; channel < 3; ++channel)
+	{
+		float* plane = tensor + channel * plane_size;
+		fill(plane, plane + static_cast<size_t>(content.y) * size, padding);
+		fill(plane + static_cast<size_t>(content.y + content.height) * size, plane + plane_size, padding);
+	}
+
+	for (int y = 0; y < content.height; ++y)
+	{
+		const int row0 = scratch.rows.index0[y];
+		const int row1 = scratch.rows.index1[y];
+		const auto& top    = resampled(scratch, frame, stride, row0, row1);
+		const auto& bottom = resampled(scratch, frame, stride, row1, row0);
+
+		const auto output_row = static_cast<size_t>(content.y + y) * size;
+		for (int channel = 0; channel < 3; ++channel)
+		{
+			float* line = tensor + channel * plane_size + output_row;
+			fill(line, line + content.x, padding);
+			blend_rows(top.planes.data() + channel * content.width, bottom.planes.data() + channel * content.width,
+			           scratch.rows.weight[y], line + content.x, content.width);
+			fill(line + content.x + content.width, line + size, padding);
+		}
+	}
+	return placement;
+}
+
+PoseModel::Letterbox Preprocess::letterbox_to_blob(const cv::Mat& frame, cv::Mat& blob, const int size)
+{
+	const int dims[] = {1, 3, size, size};
+	blob.create(4, dims, CV_32F);
+	return letterbox_to_tensor(frame.ptr<uint8_t>(), frame.cols, frame.rows, frame.step, blob.ptr<float>(), size);
+}
+
+std::string_view Preprocess::instruction_set()
+{
+#if defined(__ARM_NEON)
+	return "neon";
+#else
+	return CpuFeatures::has_avx2() ? "avx2" : "scalar";
+#endif
+}
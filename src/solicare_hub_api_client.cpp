@@ -21,7 +21,7 @@ bool SolicareCentralHomeHub::process_senior_login(std::string_view user_id, std:
 		auto res = HttpClient::requestHttps(ioc_, BASE_API_HOST, HttpClient::Method::POST, target, body, 5000);
 		if (res.error)
 		{
-			Logger::log_error(TAG, fmt::format("Login API error: {}", *res.error));
+			Logger::error(TAG, "Login API error: {}", *res.error);
 			return false;
 		}
 		if (!res.body)
@@ -39,8 +39,7 @@ bool SolicareCentralHomeHub::process_senior_login(std::string_view user_id, std:
 		const auto& res_json = *res_json_opt;
 		if (res_json.contains("message"))
 		{
-			Logger::log_info(TAG, fmt::format("API Response Message: {}", res_json["message"].get<string>()),
-			                 LOG_COLOR);
+			Logger::info(TAG, LOG_COLOR, "API Response Message: {}", res_json["message"].get<string>());
 		}
 		if (res.status == 200)
 		{
@@ -76,7 +75,7 @@ bool SolicareCentralHomeHub::process_senior_login(std::string_view user_id, std:
 	}
 	catch (const std::exception& ex)
 	{
-		Logger::log_error(TAG, fmt::format("Login exception: {}", ex.what()));
+		Logger::error(TAG, "Login exception: {}", ex.what());
 	}
 	return false;
 }
@@ -90,7 +89,7 @@ bool SolicareCentralHomeHub::fetch_monitoring_status()
 		                                                              HttpClient::Method::GET, api_path, "", 3000);
 		if (error)
 		{
-			Logger::log_error(TAG, fmt::format("Monitoring API error: {}", *error));
+			Logger::error(TAG, "Monitoring API error: {}", *error);
 			return false;
 		}
 		if (!body)
@@ -116,22 +115,21 @@ bool SolicareCentralHomeHub::fetch_monitoring_status()
 			{
 				return res_json["body"].get<bool>();
 			}
-			Logger::log_error(TAG, fmt::format("Monitoring API: unexpected body type: {}", res_json["body"].dump()));
+			Logger::error(TAG, "Monitoring API: unexpected body type: {}", res_json["body"].dump());
 		}
 		else if (res_json_opt->contains("message"))
 		{
-			Logger::log_error(TAG,
-			                  fmt::format("Monitoring API: message: {}", res_json_opt->at("message").get<string>()));
+			Logger::error(TAG, "Monitoring API: message: {}", res_json_opt->at("message").get<string>());
 		}
 		else
 		{
-			Logger::log_error(TAG, fmt::format("Monitoring API: HTTP status {}", status));
+			Logger::error(TAG, "Monitoring API: HTTP status {}", status);
 		}
 		return false;
 	}
 	catch (const std::exception& ex)
 	{
-		Logger::log_error(TAG, fmt::format("Monitoring API exception: {}", ex.what()));
+		Logger::error(TAG, "Monitoring API exception: {}", ex.what());
 		return false;
 	}
 }
@@ -155,7 +153,7 @@ bool SolicareCentralHomeHub::postSeniorAlertEvent(const std::string& eventType,
 		    ioc_, identity_.token, BASE_API_HOST, HttpClient::Method::POST, api_path, body, 5000);
 		if (error)
 		{
-			Logger::log_error(TAG, fmt::format("Alert API error: {}", *error));
+			Logger::error(TAG, "Alert API error: {}", *error);
 			return false;
 		}
 		if (!res_body)
@@ -175,21 +173,20 @@ bool SolicareCentralHomeHub::postSeniorAlertEvent(const std::string& eventType,
 			return true;
 		}
 		// 실패 시 응답 전체 로그
-		Logger::log_error(TAG, fmt::format("Alert API full response: {}", *res_body));
+		Logger::error(TAG, "Alert API full response: {}", *res_body);
 		if (res_json_opt->contains("message"))
 		{
-			Logger::log_error(TAG,
-				fmt::format("Alert API: message: {}", res_json_opt->at("message").get<std::string>()));
+			Logger::error(TAG, "Alert API: message: {}", res_json_opt->at("message").get<std::string>());
 		}
 		else
 		{
-			Logger::log_error(TAG, fmt::format("Alert API: HTTP status {}", status));
+			Logger::error(TAG, "Alert API: HTTP status {}", status);
 		}
 		return false;
 	}
 	catch (const std::exception& ex)
 	{
-		Logger::log_error(TAG, fmt::format("Alert API exception: {}", ex.what()));
+		Logger::error(TAG, "Alert API exception: {}", ex.what());
 		return false;
 	}
 }
@@ -217,7 +214,7 @@ bool SolicareCentralHomeHub::postSeniorStats(bool cameraFallDetected, bool weara
 		    ioc_, identity_.token, BASE_API_HOST, HttpClient::Method::POST, api_path, body, 5000);
 		if (error)
 		{
-			Logger::log_error(TAG, fmt::format("Stats API error: {}", *error));
+			Logger::error(TAG, "Stats API error: {}", *error);
 			return false;
 		}
 		if (!res_body)
@@ -239,18 +236,17 @@ bool SolicareCentralHomeHub::postSeniorStats(bool cameraFallDetected, bool weara
 		}
 		if (res_json_opt->contains("message"))
 		{
-			Logger::log_error(TAG,
-			                  fmt::format("Stats API: message: {}", res_json_opt->at("message").get<std::string>()));
+			Logger::error(TAG, "Stats API: message: {}", res_json_opt->at("message").get<std::string>());
 		}
 		else
 		{
-			Logger::log_error(TAG, fmt::format("Stats API: HTTP status {}", status));
+			Logger::error(TAG, "Stats API: HTTP status {}", status);
 		}
 		return false;
 	}
 	catch (const std::exception& ex)
 	{
-		Logger::log_error(TAG, fmt::format("Stats API exception: {}", ex.what()));
+		Logger::error(TAG, "Stats API exception: {}", ex.what());
 		return false;
 	}
 }
@@ -1,11 +1,18 @@
 #include <iostream>
+#include <bit>
 #include <magic_enum.hpp>
-#include <opencv2/core/cuda.hpp>
 #include <opencv2/dnn.hpp>
 #include <tbb/concurrent_queue.h>
+#include <tbb/flow_graph.h>
 
 #include "solicare_central_home_hub.hpp"
+#include "utils/metrics.hpp"
 #include "utils/opencv_utils.hpp"
+#include "vision/frame_decoder.hpp"
+#include "vision/pose_decoder.hpp"
+#include "vision/pose_inference_service.hpp"
+#include "vision/pose_model.hpp"
+#include "vision/preprocess.hpp"
 
 using namespace std;
 using namespace chrono;
@@ -14,87 +21,566 @@ using namespace magic_enum;
 
 using namespace SolicareHomeHub::CameraProcessor;
 
-std::optional<cv::dnn::Net> SolicareHomeHub::CameraProcessor::pose_net;
+PoseBackendConfig SolicareHomeHub::CameraProcessor::pose_backend_config;
+std::unique_ptr<PoseBackend> SolicareHomeHub::CameraProcessor::pose_backend;
+std::unique_ptr<PoseBackend> SolicareHomeHub::CameraProcessor::crop_pose_backend;
+std::optional<CameraPipeline> SolicareHomeHub::CameraProcessor::pipeline;
+DisplayConfig SolicareHomeHub::CameraProcessor::display_config;
+std::optional<DisplayCompositor> SolicareHomeHub::CameraProcessor::display_compositor;
+MotionGateConfig SolicareHomeHub::CameraProcessor::motion_gate_config;
+KeypointTrackerConfig SolicareHomeHub::CameraProcessor::keypoint_tracker_config;
+InferenceRegionConfig SolicareHomeHub::CameraProcessor::inference_region_config;
 
-void SolicareCentralHomeHub::process_image(const shared_ptr<WebSocketServerContext::SessionInfo>& session_info,
-                                           const shared_ptr<WebSocketServerContext::Buffer>& buffer)
+MotionGateConfig SolicareHomeHub::CameraProcessor::motion_gate_config_for(const std::string_view identification)
 {
-	const auto& data = get<shared_ptr<CameraSessionData>>(session_info->data);
+	auto config = motion_gate_config;
+	// Value after a token, up to the next ';'. Malformed values keep the default.
+	const auto value = [identification](const std::string_view token) -> optional<double>
+	{
+		const auto at = identification.find(token);
+		if (at == std::string_view::npos)
+			return nullopt;
+		const auto start = at + token.size();
+		const auto text  = string(identification.substr(start, identification.find(';', start) - start));
+		try
+		{
+			return stod(text);
+		}
+		catch (const std::exception&)
+		{
+			return nullopt;
+		}
+	};
+	if (const auto threshold = value(MOTION_THRESHOLD_TOKEN); threshold && *threshold >= 0.0)
+		config.motion_threshold = *threshold;
+	if (const auto heartbeat = value(HEARTBEAT_TOKEN); heartbeat && *heartbeat > 0.0)
+		config.heartbeat = duration_cast<milliseconds>(duration<double>(*heartbeat));
+	return config;
+}
+
+namespace
+{
+// One camera frame travelling through the graph, each stage fills in its part
+struct FrameJob
+{
+	shared_ptr<WebSocketServerContext::SessionInfo> session_info;
+	shared_ptr<CameraSessionState> camera;
+	CameraFrame frame;
+	steady_clock::time_point started;
+
+	bool discarded       = false; // Failed or stale, the remaining stages only hand it off
+	bool skip_inference  = false; // The pose model does not run for this frame
+	bool tracked         = false; // Skips the pose model, the keypoint tracker follows the person instead
+	bool feeds_camera    = false; // Pulls the camera's next frame from the mailbox, see CameraPipeline::feed()
+	unsigned buffer_slot = 0;     // Index into camera->frame_buffers, owned until the handoff
+
+	cv::Mat image;  // Decoded BGR frame, copied to the display compositor by the display stage
+	cv::Mat full;   // Full-resolution decode of image when a crop is likely, empty otherwise
+	cv::Mat tensor; // Model input, letterboxed and normalized
+	cv::Mat gray;   // Keypoint tracker input, empty for frames the motion gate found static
+	PoseModel::Letterbox letterbox; // Maps model input pixels to frame pixels, crops included
+	optional<cv::Rect> crop;        // Part of the image the pose model ran on, the full frame when empty
+	steady_clock::time_point inference_submitted;
+	PoseInferenceService::Result inference;
+	PoseDecoder::PoseDetections people; // Best scoring first, the first one is the tracked person
+	CameraSessionData snapshot; // Camera state after this frame, handed to the monitor
+};
+using FrameJobPtr = shared_ptr<FrameJob>;
+using StageNode     = tbb::flow::function_node<FrameJobPtr, FrameJobPtr>;
+using InferenceNode = tbb::flow::async_node<FrameJobPtr, FrameJobPtr>;
+
+enum STAGE_FRAMES
+{
+	ALL_FRAMES,
+	INFERRED_FRAMES // Frames that go through the pose model
+};
+
+// Wraps a stage body with its timer and error handling, discarded frames pass through untouched, and so do frames
+// without inference for a stage of INFERRED_FRAMES.
+// An exception must not escape a node body, it would cancel the whole graph.
+template <typename Body>
+auto timed_stage(const std::string_view name, Body body, const STAGE_FRAMES frames = ALL_FRAMES)
+{
+	auto& stage_seconds = Metrics::registry().histogram(
+	    "solicare_camera_stage_seconds", "Time spent in one stage of the camera pipeline",
+	    fmt::format(R"(stage="{}")", name));
+	return [name, body, frames, &stage_seconds](const FrameJobPtr& job)
+	{
+		if (job->discarded || (frames == INFERRED_FRAMES && job->skip_inference))
+			return job;
+		const Metrics::ScopedTimer timer(stage_seconds);
+		try
+		{
+			body(*job);
+		}
+		catch (const std::exception& e)
+		{
+			job->discarded = true;
+			Logger::error(TAG, "[{}] {}: {}", name, job->camera->data.device_tag, e.what());
+		}
+		return job;
+	};
+}
+
+// A camera never has more frames in flight than buffers, so a free one always exists
+unsigned acquire_frame_buffers(CameraSessionState& camera)
+{
+	auto free_buffers = camera.free_frame_buffers.load();
+	while (true)
+	{
+		const auto slot = static_cast<unsigned>(countr_zero(free_buffers));
+		if (camera.free_frame_buffers.compare_exchange_weak(free_buffers, free_buffers & ~(1u << slot)))
+			return slot;
+	}
+}
+
+void release_frame_buffers(CameraSessionState& camera, const unsigned slot)
+{
+	camera.free_frame_buffers.fetch_or(1u << slot);
+}
+
+// Decodes at the smallest DCT scale that still covers the model input, e.g. 1080p frames at half resolution.
+// While a person is followed and crops are on, the frame is decoded in full instead and scaled down to the same
+// size, preprocess cuts the crop from the full-resolution image so a small subject keeps its detail.
+void decode_frame(FrameJob& job, const bool crops)
+{
+	static auto& reduced_decodes = Metrics::registry().counter(
+	    "solicare_camera_reduced_decodes_total", "Camera frames decoded below their full resolution");
+	const auto& buffer = job.frame.buffer;
+	const auto* bytes  = static_cast<const uint8_t*>(buffer->data().data());
+	const auto size    = FrameDecoder::jpeg_size(bytes, buffer->size());
+	const int flags    = size ? FrameDecoder::reduced_decode_flag(*size, PoseModel::INPUT_SIZE) : cv::IMREAD_COLOR;
+	const bool full    = crops && flags != cv::IMREAD_COLOR && job.camera->inference_region.following();
 
+	auto& buffers = job.camera->frame_buffers[job.buffer_slot];
 	const cv::Mat bufferedImage(1, static_cast<int>(buffer->size()), CV_8U, buffer->data().data());
-	const cv::Mat decoded_image = cv::imdecode(bufferedImage, cv::IMREAD_COLOR);
-	if (decoded_image.empty())
+	if (full)
+	{
+		cv::imdecode(bufferedImage, cv::IMREAD_COLOR, &buffers.full);
+		job.full = buffers.full;
+		if (!job.full.empty())
+		{
+			cv::resize(job.full, buffers.decoded, FrameDecoder::reduced_size(*size, flags), 0, 0, cv::INTER_AREA);
+			job.image = buffers.decoded;
+		}
+	}
+	else
+	{
+		if (flags != cv::IMREAD_COLOR)
+			reduced_decodes.add();
+		cv::imdecode(bufferedImage, flags, &buffers.decoded);
+		job.image = buffers.decoded;
+	}
+	job.frame.buffer.reset(); // Returns the read buffer to the pool as early as possible
+	if (job.image.empty())
 	{
-		Logger::log_error(TAG,
-		                  fmt::format("[Decode] Failed to decode image data from {}: invalid format or corrupted data",
-		                              data->device_tag));
+		job.discarded = true;
+		Logger::error(TAG, "[Decode] Failed to decode image data from {}: invalid format or corrupted data",
+		              job.camera->data.device_tag);
+	}
+}
+
+// Static frames skip the pose model, of the others the keypoint tracker decides which ones need it.
+// utilization: busy fraction of the inference thread, the tracker stretches its interval when it is saturated.
+void gate_frame(FrameJob& job, const double utilization)
+{
+	auto& camera       = *job.camera;
+	job.skip_inference = !camera.motion_gate.evaluate(job.image, job.started).infer;
+	if (job.skip_inference || !camera.keypoint_tracker.config().enabled)
 		return;
+
+	auto& gray = camera.frame_buffers[job.buffer_slot].gray;
+	cv::cvtColor(job.image, gray, cv::COLOR_BGR2GRAY);
+	job.gray           = gray;
+	job.tracked        = !camera.keypoint_tracker.needs_detection(utilization);
+	job.skip_inference = job.tracked;
+}
+
+// crops: the model accepts the smaller input of a crop, see probe_crop_inference()
+void preprocess_frame(FrameJob& job, const bool crops)
+{
+	auto& camera  = *job.camera;
+	auto& buffers = camera.frame_buffers[job.buffer_slot];
+	if (crops)
+		job.crop = camera.inference_region.next(job.image.size());
+	if (!job.crop)
+	{
+		job.letterbox = Preprocess::letterbox_to_blob(job.image, buffers.tensor);
+		job.tensor    = buffers.tensor;
+		return;
+	}
+	const int size = camera.inference_region.config().input_size;
+	job.tensor     = buffers.roi_tensor;
+	if (job.full.empty())
+	{
+		const auto letterbox = Preprocess::letterbox_to_blob(job.image(*job.crop), buffers.roi_tensor, size);
+		job.letterbox        = offset_letterbox(letterbox, job.crop->tl());
+		return;
+	}
+
+	// The same crop in full-resolution pixels, its letterbox mapped back to the pixels of image
+	const double factor = static_cast<double>(job.full.cols) / job.image.cols;
+	const cv::Rect full_crop =
+	    cv::Rect(cvRound(job.crop->x * factor), cvRound(job.crop->y * factor), cvRound(job.crop->width * factor),
+	             cvRound(job.crop->height * factor)) &
+	    cv::Rect(0, 0, job.full.cols, job.full.rows);
+	const auto letterbox = Preprocess::letterbox_to_blob(job.full(full_crop), buffers.roi_tensor, size);
+	job.letterbox        = offset_letterbox(letterbox, full_crop.tl());
+	job.letterbox.scale *= static_cast<float>(factor);
+	job.full.release();
+}
+
+// Runs the model once on a crop sized input, a model exported without dynamic shapes rejects it
+bool probe_crop_inference(PoseBackend& backend, const int size)
+{
+	if (!inference_region_config.enabled)
+		return false;
+	try
+	{
+		const int dims[] = {1, 3, size, size};
+		cv::Mat blob(4, dims, CV_32F);
+		blob.setTo(cv::Scalar::all(0));
+		const cv::Mat output = backend.forward(blob);
+		if (output.dims == 3 && output.size[2] == PoseModel::anchor_count(size))
+		{
+			Logger::info(TAG, LOG_COLOR, "[ROI] Cropped inference at {}x{} enabled", size, size);
+			return true;
+		}
+	}
+	catch (const std::exception& e) // cv::Exception, Ort::Exception
+	{
+		Logger::warn(TAG, "[ROI] {}x{} input rejected: {}", size, size, e.what());
 	}
-	cv::cuda::GpuMat gpu_decoded_image;
-	gpu_decoded_image.upload(decoded_image);
-
-	// std::vector<cv::Point2f> keypoints;
-	// cv::Mat blob = cv::dnn::blobFromImage(decoded_image, 1.0 / 255.0, cv::Size(640, 640), cv::Scalar(), true,
-	// false); pose_net->setInput(blob); cv::Mat output; try
-	// {
-	// 	output = pose_net->forward();
-	// }
-	// catch (const cv::Exception& e)
-	// {
-	// 	std::cerr << "[OpenCV DNN] forward() error: " << e.what() << std::endl;
-	// 	Logger::log_error(TAG, fmt::format("[OpenCV DNN] forward() error: {}", e.what()));
-	// 	return;
-	// }
-	// // output: [1, N, 56] (N: 감지된 사람 수, 56: bbox+keypoints)
-	// // keypoints: 17개 (x, y, conf)씩
-	// if (output.dims == 3)
-	// {
-	// 	int num = output.size[1];
-	// 	for (int i = 0; i < num; ++i)
-	// 	{
-	// 		const float* row = output.ptr<float>(0, i);
-	// 		for (int k = 0; k < 17; ++k)
-	// 		{
-	// 			float x    = row[6 + k * 3];
-	// 			float y    = row[6 + k * 3 + 1];
-	// 			float conf = row[6 + k * 3 + 2];
-	// 			if (conf > 0.3)
-	// 				keypoints.emplace_back(x, y);
-	// 		}
-	// 		break; // 첫 번째 사람만
-	// 	}
-	// }
-	//
-	// // COCO keypoint 연결 순서
-	// static const std::vector<std::pair<int, int>> skeleton = {
-	//     {0, 1},  {1, 2},   {2, 3},   {3, 4},   // 오른팔
-	//     {0, 5},  {5, 6},   {6, 7},   {7, 8},   // 왼팔
-	//     {0, 9},  {9, 10},  {10, 11}, {11, 12}, // 오른다리
-	//     {0, 13}, {13, 14}, {14, 15}, {15, 16}  // 왼다리
-	// };
-	// for (const auto& [i, j] : skeleton)
-	// {
-	// 	if (i < keypoints.size() && j < keypoints.size())
-	// 	{
-	// 		cv::line(decoded_image, keypoints[i], keypoints[j], cv::Scalar(0, 255, 0), 2);
-	// 	}
-	// }
-	// for (const auto& pt : keypoints)
-	// {
-	// 	cv::circle(decoded_image, pt, 3, cv::Scalar(0, 0, 255), -1);
-	// }
-
-	const double fps = 1.0 / duration<double>(steady_clock::now() - session_info->timepoint_last_processed).count();
-	cv::Mat cpu_decoded_image;
-	gpu_decoded_image.download(cpu_decoded_image);
-	OpenCVUtils::put_text_overlay(cpu_decoded_image, cv::String(enum_name<PersonPosture>(data->pose)),
+	Logger::warn(TAG, "[ROI] {} needs a dynamic-shape model for cropped inference, every frame runs in full",
+	             backend.name());
+	return false;
+}
+
+void postprocess_frame(FrameJob& job)
+{
+	if (!job.inference.error.empty())
+	{
+		job.discarded = true; // Already logged by the inference service
+		return;
+	}
+	PoseDecoder::decode(job.inference.output(), job.letterbox, job.people);
+	job.inference = {}; // Releases the batch output once every frame of the batch is decoded
+}
+
+PersonPosture to_person_posture(const BODY_POSTURE posture)
+{
+	switch (posture)
+	{
+	case POSTURE_STANDING:
+		return STANDING;
+	case POSTURE_SITTING:
+		return SITTING;
+	case POSTURE_LYING:
+		return LYING;
+	case POSTURE_FALLEN:
+		return FALLEN;
+	default:
+		return UNKNOWN;
+	}
+}
+
+// The only stage that writes CameraSessionData. Cameras are classified in parallel, each under its classify_mutex.
+void classify_posture(FrameJob& job)
+{
+	auto& camera = *job.camera;
+	const lock_guard lock(camera.classify_mutex);
+	auto& data = camera.data;
+	if (job.skip_inference && !job.tracked)
+	{
+		// A static frame only reports the current state. It leaves last_sequence alone, or the detection of an
+		// earlier frame still in the pose model, e.g. the heartbeat, would be discarded as stale when it arrives.
+		job.snapshot = data;
+		return;
+	}
+	if (job.frame.sequence < camera.last_sequence)
+	{
+		// Overtaken by a newer frame of the same camera, its result would move the state backwards. A detection
+		// overtaken by tracked frames still corrects the track.
+		if (const int followed = camera.person_follower.match(job.people);
+		    !job.skip_inference && followed >= 0 && !job.gray.empty())
+			camera.keypoint_tracker.detected_late(job.people.items[followed], job.gray);
+		static auto& stale_frames = Metrics::registry().counter(
+		    "solicare_camera_stale_frames_total", "Camera frames discarded because a newer frame finished first");
+		stale_frames.add();
+		job.discarded = true;
+		return;
+	}
+	camera.last_sequence = job.frame.sequence;
+
+	const PoseModel::PoseDetection* person = nullptr; // The followed one of the people in view
+	if (job.tracked)
+	{
+		const auto tracked = camera.keypoint_tracker.track(job.gray);
+		job.people.count   = tracked ? 1 : 0;
+		if (tracked)
+		{
+			job.people.items[0] = *tracked;
+			person              = &job.people.front();
+			camera.person_follower.follow(*person);
+		}
+	}
+	else
+	{
+		// Moved to the front, where the display and the monitor expect the person the camera reports on
+		if (const int followed = camera.person_follower.select(job.people); followed >= 0)
+		{
+			swap(job.people.items[0], job.people.items[followed]);
+			person = &job.people.front();
+		}
+		if (camera.person_follower.switched())
+			camera.body_points.clear(); // The history is of one person, the fall detector's features too
+		if (!job.gray.empty())
+			camera.keypoint_tracker.detected(person, job.gray);
+	}
+	camera.inference_region.update(person);
+	if (person)
+	{
+		camera.body_points.push(*person, job.started);
+		camera.fall_detector.update(camera.body_points.window());
+	}
+	else
+		camera.fall_detector.update_missing(job.started);
+
+	const PersonPosture posture = to_person_posture(camera.fall_detector.posture());
+	if (posture == FALLEN && data.pose != FALLEN)
+	{
+		static auto& falls = Metrics::registry().counter("solicare_camera_falls_total", "Falls detected by cameras");
+		falls.add();
+		Logger::warn(TAG, "[Classify] Fall detected by {}", data.device_tag);
+	}
+	data.pose    = posture;
+	job.snapshot = data;
+}
+
+// Drawn over a frame by the display compositor, captured when the frame is published and only drawn if it is shown
+struct FrameAnnotations
+{
+	PoseDecoder::PoseDetections people;
+	optional<cv::Rect> crop;
+	PersonPosture posture = UNKNOWN;
+	double fps            = 0.0;
+	uint64_t dropped      = 0;
+	bool tracked          = false;
+	optional<double> idle_skipped; // Percentage of frames the motion gate skipped, set for idle frames
+};
+
+void annotate(cv::Mat& image, const FrameAnnotations& annotations)
+{
+	if (annotations.crop)
+		cv::rectangle(image, *annotations.crop, cv::Scalar(0, 255, 255), 1);
+	for (const auto& person : annotations.people)
+	{
+		const auto visible = [&person](const int k) { return person.confidence[k] > PoseModel::KEYPOINT_THRESHOLD; };
+		cv::rectangle(image, cv::Rect(person.box), cv::Scalar(255, 0, 0), 2);
+		for (const auto& [i, j] : PoseModel::SKELETON)
+		{
+			if (visible(i) && visible(j))
+				cv::line(image, person.keypoints[i], person.keypoints[j], cv::Scalar(0, 255, 0), 2);
+		}
+		for (int k = 0; k < PoseModel::KEYPOINT_COUNT; ++k)
+		{
+			if (visible(k))
+				cv::circle(image, person.keypoints[k], 3, cv::Scalar(0, 0, 255), -1);
+		}
+	}
+
+	OpenCVUtils::put_text_overlay(image, cv::String(enum_name<PersonPosture>(annotations.posture)),
 	                              OpenCVUtils::TEXT_TOP_RIGHT, OpenCVUtils::COLOR_RED);
-	OpenCVUtils::put_text_overlay(cpu_decoded_image, fmt::format("FPS(Process): {}", static_cast<int>(fps)),
+	OpenCVUtils::put_text_overlay(image, fmt::format("FPS(Process): {}", static_cast<int>(annotations.fps)),
 	                              OpenCVUtils::TEXT_TOP_LEFT, OpenCVUtils::COLOR_GREEN);
-	cv::imshow(data->device_tag, cpu_decoded_image);
-	cv::waitKey(1);
+	OpenCVUtils::put_text_overlay(image, fmt::format("Dropped: {}", annotations.dropped),
+	                              OpenCVUtils::TEXT_BOTTOM_LEFT, OpenCVUtils::COLOR_YELLOW);
+	if (annotations.tracked)
+	{
+		OpenCVUtils::put_text_overlay(image, "Tracked", OpenCVUtils::TEXT_BOTTOM_RIGHT, OpenCVUtils::COLOR_WHITE);
+	}
+	else if (annotations.idle_skipped)
+	{
+		OpenCVUtils::put_text_overlay(image, fmt::format("Idle ({:.0f}% skipped)", *annotations.idle_skipped),
+		                              OpenCVUtils::TEXT_BOTTOM_RIGHT, OpenCVUtils::COLOR_WHITE);
+	}
+}
+
+// Serial, so the frames of a camera reach the compositor in order. Headless, there is nothing to do.
+void display_frame(FrameJob& job)
+{
+	if (!display_compositor || job.frame.sequence < job.camera->last_displayed)
+		return; // Classified in parallel with a newer frame of the camera that was shown already
+	if (job.session_info->timepoint_disconnected.load() != steady_clock::time_point{})
+		return; // The camera's window was closed, a frame would reopen it
+	job.camera->last_displayed = job.frame.sequence;
+	FrameAnnotations annotations;
+	annotations.people  = job.people;
+	annotations.crop    = job.crop;
+	annotations.posture = job.snapshot.pose;
+	annotations.fps =
+	    1.0 / duration<double>(steady_clock::now() - job.session_info->timepoint_last_processed.load()).count();
+	annotations.dropped = job.camera->mailbox.dropped();
+	annotations.tracked = job.tracked;
+	if (job.skip_inference && !job.tracked)
+		annotations.idle_skipped = 100.0 * job.camera->motion_gate.skip_ratio();
+	auto overlay = [annotations = std::move(annotations)](cv::Mat& image) { annotate(image, annotations); };
+	display_compositor->publish(job.snapshot.device_tag, job.image, std::move(overlay));
+}
+} // namespace
 
-	// push SessionData to camera_data_queue for monitoring (Copy)
-	SolicareHomeHub::Monitor::camera_data_queue.push(*data);
-	SolicareHomeHub::Monitor::camera_last_data_pushed_time = steady_clock::now();
+struct CameraPipeline::Graph
+{
+	explicit Graph(const size_t parallel_frames)
+	    : decode(graph, parallel_frames,
+	             [this, stage = timed_stage("decode", [this](FrameJob& job) { decode_frame(job, crop_inference); })](
+	                 const FrameJobPtr& job)
+	             {
+		             stage(job);
+		             pass_feed(job);
+		             return job;
+	             }),
+	      gate(graph, parallel_frames,
+	           timed_stage("gate", [this](FrameJob& job) { gate_frame(job, inference_service.utilization()); })),
+	      preprocess(graph, parallel_frames,
+	                 timed_stage("preprocess", [this](FrameJob& job) { preprocess_frame(job, crop_inference); },
+	                             INFERRED_FRAMES)),
+	      inference(graph, tbb::flow::unlimited, [this](const FrameJobPtr& job, InferenceNode::gateway_type& gateway)
+	                { infer(job, gateway); }),
+	      postprocess(graph, parallel_frames, timed_stage("postprocess", postprocess_frame, INFERRED_FRAMES)),
+	      classify(graph, parallel_frames, timed_stage("classify", classify_posture)),
+	      display(graph, tbb::flow::serial, timed_stage("display", display_frame)),
+	      handoff(graph, tbb::flow::unlimited, [this](const FrameJobPtr& job) { hand_off(job); }),
+	      inference_service(*pose_backend, INFERENCE_MAX_BATCH_SIZE, INFERENCE_MAX_BATCH_DELAY)
+	{
+		tbb::flow::make_edge(decode, gate);
+		tbb::flow::make_edge(gate, preprocess);
+		tbb::flow::make_edge(preprocess, inference);
+		tbb::flow::make_edge(inference, postprocess);
+		tbb::flow::make_edge(postprocess, classify);
+		tbb::flow::make_edge(classify, display);
+		tbb::flow::make_edge(display, handoff);
+		// Before the first frame, the inference thread does not use the backends yet
+		const int crop_size = inference_region_config.input_size;
+		crop_inference      = probe_crop_inference(crop_pose_backend ? *crop_pose_backend : *pose_backend, crop_size);
+		if (!crop_inference)
+			crop_pose_backend.reset(); // A static-shape model, the second copy would never run
+		else if (crop_pose_backend)
+			inference_service.add_backend(crop_size, *crop_pose_backend);
+	}
+
+	// The camera's mailbox has a single consumer, represented by the one job of the camera that carries feeds_camera.
+	// That job takes the next frame once it has been decoded if the camera has room for another frame in flight,
+	// otherwise once it has been handed off. When the mailbox is empty the consumer goes idle until the next post().
+	void feed(const shared_ptr<WebSocketServerContext::SessionInfo>& session_info,
+	          const shared_ptr<CameraSessionState>& camera)
+	{
+		auto frame = camera->mailbox.take();
+		if (!frame)
+			return;
+		camera->frames_in_flight.fetch_add(1);
+		const auto job    = make_shared<FrameJob>();
+		job->session_info = session_info;
+		job->camera       = camera;
+		job->frame        = std::move(*frame);
+		job->started      = steady_clock::now();
+		job->feeds_camera = true;
+		job->buffer_slot  = acquire_frame_buffers(*camera);
+		decode.try_put(job);
+	}
+
+	void pass_feed(const FrameJobPtr& job)
+	{
+		if (job->feeds_camera && job->camera->frames_in_flight.load() < MAX_FRAMES_IN_FLIGHT)
+		{
+			job->feeds_camera = false;
+			feed(job->session_info, job->camera);
+		}
+	}
+
+	// Hands the frame to the batching service, the job continues from the service's thread once its batch is done.
+	// The graph counts the frame as in flight meanwhile, so wait_for_all() also waits for pending batches.
+	void infer(const FrameJobPtr& job, InferenceNode::gateway_type& gateway)
+	{
+		if (job->discarded || job->skip_inference)
+		{
+			gateway.try_put(job);
+			return;
+		}
+		gateway.reserve_wait();
+		job->inference_submitted = steady_clock::now();
+		inference_service.submit(job->tensor,
+		                         [job, &gateway](PoseInferenceService::Result result)
+		                         {
+			                         static auto& stage_seconds = Metrics::registry().histogram(
+			                             "solicare_camera_stage_seconds",
+			                             "Time spent in one stage of the camera pipeline", R"(stage="inference")");
+			                         stage_seconds.observe(steady_clock::now() - job->inference_submitted);
+			                         job->inference = std::move(result);
+			                         job->tensor.release();
+			                         gateway.try_put(job);
+			                         gateway.release_wait();
+		                         });
+	}
+
+	void hand_off(const FrameJobPtr& job)
+	{
+		static auto& process_seconds = Metrics::registry().histogram(
+		    "solicare_frame_process_seconds", "Time spent processing one frame", R"(type="camera")");
+		if (!job->discarded)
+		{
+			SolicareHomeHub::Monitor::camera_data_queue.push(std::move(job->snapshot));
+			SolicareHomeHub::Monitor::camera_last_data_pushed_time = steady_clock::now();
+			job->session_info->acknowledge(job->frame.sequence);
+		}
+		job->session_info->timepoint_last_processed = steady_clock::now();
+		process_seconds.observe(steady_clock::now() - job->started);
+
+		job->image.release();
+		job->full.release();
+		job->tensor.release();
+		job->gray.release();
+		release_frame_buffers(*job->camera, job->buffer_slot);
+		job->camera->frames_in_flight.fetch_sub(1);
+		if (job->feeds_camera)
+			feed(job->session_info, job->camera);
+	}
+
+	tbb::flow::graph graph; // Declared first, nodes have to be destroyed before their graph
+	StageNode decode, gate, preprocess;
+	InferenceNode inference;
+	StageNode postprocess, classify, display;
+	tbb::flow::function_node<FrameJobPtr> handoff;
+	bool crop_inference = false;            // The model accepts crops at inference_region_config.input_size
+	PoseInferenceService inference_service; // Declared last, its thread stops before the nodes it feeds are gone
+};
+
+CameraPipeline::CameraPipeline(const size_t parallel_frames)
+    : graph_(make_unique<Graph>(max<size_t>(1, parallel_frames)))
+{
+}
+
+CameraPipeline::~CameraPipeline()
+{
+	wait_for_all();
+}
+
+void CameraPipeline::feed(const shared_ptr<WebSocketServerContext::SessionInfo>& session_info,
+                          const shared_ptr<CameraSessionState>& camera)
+{
+	graph_->feed(session_info, camera);
+}
+
+void CameraPipeline::wait_for_all()
+{
+	graph_->graph.wait_for_all();
+}
+
+void SolicareCentralHomeHub::submit_image(const shared_ptr<WebSocketServerContext::SessionInfo>& session_info,
+                                          CameraFrame frame)
+{
+	const auto& camera = get<shared_ptr<CameraSessionState>>(session_info->data);
+	if (camera->mailbox.post(std::move(frame)).wake_consumer && pipeline)
+		pipeline->feed(session_info, camera); // No pipeline without a pose model, the mailbox keeps the newest frame
+	// Otherwise a frame of this camera in the pipeline picks up the newest one, an older unprocessed one is dropped
 }
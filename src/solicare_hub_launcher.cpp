@@ -10,29 +10,109 @@ using namespace SolicareHomeHub::Launcher;
 
 SolicareCentralHomeHub::SolicareCentralHomeHub()
 {
-	using SolicareHomeHub::CameraProcessor::pose_net;
+	using SolicareHomeHub::CameraProcessor::pose_backend;
+	using SolicareHomeHub::CameraProcessor::pose_backend_config;
 	const int cuda_devices_count = OpenCVUtils::enable_cuda_devices();
-	pose_net.emplace(cv::dnn::readNetFromONNX(SolicareHomeHub::CameraProcessor::YOLOV8_POSE_MODEL_PATH));
-	if (cuda_devices_count > 0)
+	if (const char* backend = getenv("SOLICARE_POSE_BACKEND"))
 	{
+		if (const auto parsed = parse_pose_backend(backend))
+			pose_backend_config.backend = *parsed;
+		else
+			Logger::warn(TAG, "Unknown SOLICARE_POSE_BACKEND '{}', using {}.", backend,
+			             to_string(pose_backend_config.backend));
+	}
+	if (const char* precision = getenv("SOLICARE_POSE_PRECISION"))
+	{
+		if (const auto parsed = parse_pose_precision(precision))
+			pose_backend_config.precision = *parsed;
+		else
+			Logger::warn(TAG, "Unknown SOLICARE_POSE_PRECISION '{}', using {}.", precision,
+			             to_string(pose_backend_config.precision));
+	}
+	if (const char* gate = getenv("SOLICARE_MOTION_GATE"); gate && string_view(gate) == "0")
+	{
+		SolicareHomeHub::CameraProcessor::motion_gate_config.enabled = false;
+		log_info(TAG, "Motion gate disabled, every camera frame runs the pose model.");
+	}
+	if (const char* tracker = getenv("SOLICARE_KEYPOINT_TRACKER"); tracker && string_view(tracker) == "0")
+	{
+		SolicareHomeHub::CameraProcessor::keypoint_tracker_config.enabled = false;
+		log_info(TAG, "Keypoint tracker disabled, the pose model runs on every camera frame with motion.");
+	}
+	if (const char* roi = getenv("SOLICARE_ROI_INFERENCE"); roi && string_view(roi) == "0")
+	{
+		SolicareHomeHub::CameraProcessor::inference_region_config.enabled = false;
+		log_info(TAG, "Cropped inference disabled, the pose model always runs on the full frame.");
+	}
+	using SolicareHomeHub::CameraProcessor::display_config;
+	if (const char* headless = getenv("SOLICARE_HEADLESS"); headless && string_view(headless) == "1")
+		display_config.enabled = false;
+#ifdef __linux__
+	else if (!getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY"))
+	{
+		display_config.enabled = false;
+		log_info(TAG, "No display found, running headless.");
+	}
+#endif
+	if (const char* fps = getenv("SOLICARE_DISPLAY_FPS"))
+	{
+		if (const double parsed = strtod(fps, nullptr); parsed > 0.0)
+			display_config.max_fps = parsed;
+	}
+	if (const char* mosaic = getenv("SOLICARE_DISPLAY_MOSAIC"); mosaic && string_view(mosaic) == "1")
+		display_config.mosaic = true;
+	if (const char* sessions = getenv("SOLICARE_MAX_SESSIONS"))
+	{
+		// Load runs simulate more devices than a home has
+		if (const long parsed = strtol(sessions, nullptr, 10); parsed > 0)
+			WebSocketServerContext::ws_server_config.max_session = static_cast<int>(parsed);
+	}
+	if (const char* threads = getenv("SOLICARE_POSE_THREADS"))
+	{
+		if (const long parsed = strtol(threads, nullptr, 10); parsed > 0)
+			pose_backend_config.threads = static_cast<int>(parsed);
+	}
+	if (pose_backend_config.backend == BACKEND_AUTO)
+	{
+		pose_backend_config.backend = cuda_devices_count > 0 ? BACKEND_OPENCV_CUDA : BACKEND_OPENCV_CPU;
+	}
+	// The only place the OpenCV thread pool is sized, it is shared by OpenCV DNN and every other OpenCV call
+	if (pose_backend_config.threads > 0)
+		cv::setNumThreads(pose_backend_config.threads);
+	try
+	{
+		pose_backend = make_pose_backend(pose_backend_config);
+		Logger::info(TAG, ConsoleColor::GREEN, "Pose model {} loaded with the {} backend.",
+		             pose_backend_config.model_path(), pose_backend->name());
+	}
+	catch (const std::exception& e)
+	{
+		Logger::warn(TAG, "Failed to load the pose model with the {}/{} backend, using opencv/fp32: {}",
+		             to_string(pose_backend_config.backend), to_string(pose_backend_config.precision), e.what());
+		pose_backend_config.backend   = BACKEND_OPENCV_CPU;
+		pose_backend_config.precision = PRECISION_FP32;
 		try
 		{
-			pose_net->setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
-			pose_net->setPreferableTarget(cv::dnn::DNN_TARGET_CUDA);
-			log_info(TAG, "Sucessfully set CUDA backend and target to DNN model.", ConsoleColor::GREEN);
+			pose_backend = make_pose_backend(pose_backend_config);
 		}
-		catch (const std::exception& e)
+		catch (const std::exception& fallback_error)
 		{
-			log_warn(TAG, fmt::format("Failed to set CUDA backend and target to DNN model: {}", e.what()));
-			pose_net->setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-			pose_net->setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+			// Still serves wearables; camera frames are dropped, see submit_image()
+			Logger::error(TAG, "Failed to load the pose model {}, camera frames will not be processed: {}",
+			              pose_backend_config.model_path(), fallback_error.what());
 		}
 	}
-	else
+	if (pose_backend && SolicareHomeHub::CameraProcessor::inference_region_config.enabled)
 	{
-		log_warn(TAG, "No CUDA device found. Using CPU backend for DNN model.");
-		pose_net->setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-		pose_net->setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+		try
+		{
+			SolicareHomeHub::CameraProcessor::crop_pose_backend = make_pose_backend(pose_backend_config);
+		}
+		catch (const std::exception& e)
+		{
+			Logger::warn(TAG, "Failed to load a second pose model for crops, crops share the full frame one: {}",
+			             e.what());
+		}
 	}
 	ioc_work_guard_.emplace(ioc_.get_executor());
 	io_context_run_thread_ = std::thread(
@@ -47,13 +127,12 @@ SolicareCentralHomeHub::SolicareCentralHomeHub()
 		    {
 			    if (e.code() != boost::asio::error::operation_aborted)
 			    {
-				    log_error(TAG,
-				              fmt::format("io_context.run() system_error: {} (code: {})", e.what(), e.code().value()));
+				    Logger::error(TAG, "io_context.run() system_error: {} (code: {})", e.what(), e.code().value());
 			    }
 		    }
 		    catch (const std::exception& e)
 		    {
-			    log_error(TAG, fmt::format("io_context.run() exception: {}", e.what()));
+			    Logger::error(TAG, "io_context.run() exception: {}", e.what());
 			    ioc_.stop();
 		    }
 		    catch (...)
@@ -62,6 +141,26 @@ SolicareCentralHomeHub::SolicareCentralHomeHub()
 			    ioc_.stop();
 		    }
 	    });
+	if (display_config.enabled)
+		SolicareHomeHub::CameraProcessor::display_compositor.emplace(display_config);
+	if (pose_backend)
+		SolicareHomeHub::CameraProcessor::pipeline.emplace(max(1u, thread::hardware_concurrency() / 2));
+	ws_io_context_pool_ = make_unique<IoContextPool>(WebSocketServerContext::ws_server_config.io_context_pool_size);
+	ws_io_context_pool_->run();
+	SolicareHomeHub::SessionManager::register_metrics();
+	if (const auto metrics_port = WebSocketServerContext::ws_server_config.metrics_port; metrics_port > 0)
+	{
+		try
+		{
+			metrics_server_ = make_shared<MetricsServer>(ioc_, static_cast<unsigned short>(metrics_port));
+			metrics_server_->start();
+		}
+		catch (const std::exception& e)
+		{
+			Logger::warn(TAG, "Metrics endpoint disabled, cannot listen on port {}: {}", metrics_port, e.what());
+			metrics_server_.reset();
+		}
+	}
 	log_info(TAG, "Successfully initialized Solicare Central Home Hub.", LOG_COLOR);
 }
 
@@ -73,6 +172,16 @@ SolicareCentralHomeHub::~SolicareCentralHomeHub()
 		websocket_server_->stop(); // 서버 안전 종료
 		websocket_server_.reset();
 	}
+	if (ws_io_context_pool_)
+	{
+		ws_io_context_pool_->stop();
+	}
+	if (metrics_server_)
+	{
+		metrics_server_->stop();
+	}
+	SolicareHomeHub::CameraProcessor::pipeline.reset(); // Waits for the frames in flight
+	SolicareHomeHub::CameraProcessor::display_compositor.reset();
 	if (ioc_work_guard_)
 	{
 		ioc_work_guard_->reset();
@@ -99,10 +208,9 @@ void SolicareCentralHomeHub::runtime()
 				remove_tag_filter();
 			}
 
-			log_info(TAG,
-			         fmt::format("서버가 {} 포트에서 실행 중입니다. 로그 출력을 끄고 메뉴를 표시하려면 'm'을 누르세요.",
-			                     WebSocketServerContext::ws_server_config.server_port),
-			         ConsoleColor::GREEN);
+			Logger::info(TAG, ConsoleColor::GREEN,
+			             "서버가 {} 포트에서 실행 중입니다. 로그 출력을 끄고 메뉴를 표시하려면 'm'을 누르세요.",
+			             WebSocketServerContext::ws_server_config.server_port);
 
 			while (true)
 			{
@@ -160,6 +268,7 @@ void SolicareCentralHomeHub::on_menu_server_start()
 		unsigned short port = 0;
 		while (true)
 		{
+			flush();
 			std::cout << "서버 포트 입력 (1024~65535 권장): ";
 			cin >> port;
 			if (cin.fail())
@@ -184,14 +293,14 @@ void SolicareCentralHomeHub::on_menu_server_start()
 			WebSocketServerContext::flag_stop_server             = false;
 			WebSocketServerContext::ws_server_config.server_port = port;
 			WebSocketServerContext::ws_session_map.clear();
-			websocket_server_ = make_shared<AsyncWebSocketServer>(ioc_);
+			websocket_server_ = make_shared<AsyncWebSocketServer>(ioc_, *ws_io_context_pool_);
 			websocket_server_->start();
 			// TODO: 사용자에게 실제로 알림을 전송할 것 인지 물어보기
 			start_monitoring();
 		}
 		catch (const boost::system::system_error& e)
 		{
-			log_error(TAG, fmt::format("서버 바인딩 실패: {}", e.what()));
+			Logger::error(TAG, "서버 바인딩 실패: {}", e.what());
 			this_thread::sleep_for(milliseconds(500));
 			if (port <= 1024)
 			{
@@ -218,14 +327,13 @@ void SolicareCentralHomeHub::on_menu_server_start()
 void SolicareCentralHomeHub::on_menu_server_stop()
 {
 	remove_tag_filter();
-	cv::waitKey(1);
-	cv::destroyAllWindows();
+	if (SolicareHomeHub::CameraProcessor::display_compositor)
+		SolicareHomeHub::CameraProcessor::display_compositor->close_all();
 	if (websocket_server_)
 	{
 		stop_monitoring();
 		log_info(TAG, "서버 종료를 대기하는 중 입니다.", LOG_COLOR);
 		websocket_server_->stop();
-		this_thread::sleep_for(milliseconds(1000));
 		websocket_server_.reset();
 		log_info(TAG, "서버가 성공적으로 중지되었습니다.\n", ConsoleColor::GREEN);
 	}
@@ -238,8 +346,13 @@ void SolicareCentralHomeHub::on_menu_server_stop()
 
 int main()
 {
-	SolicareCentralHomeHub hub;
-	hub.login();
-	hub.runtime();
+	// Keeps logging off the camera and network threads, see Logger::start_async_logging()
+	start_async_logging(8192, OverflowPolicy::DROP);
+	{
+		SolicareCentralHomeHub hub;
+		hub.login();
+		hub.runtime();
+	}
+	stop_async_logging();
 	return 0;
 }
\ No newline at end of file
@@ -11,6 +11,7 @@ void SolicareCentralHomeHub::login()
 	bool logged_in = false;
 	while (!logged_in)
 	{
+		flush(); // Queued log lines must not end up in the middle of the prompt
 		constexpr int width = 40;
 		std::cout << string(width, '=') << std::endl;
 		std::cout << "|" << std::setw(width - 2) << std::setfill(' ') << std::left << "      Solicare Central Home Hub"
@@ -50,6 +51,7 @@ int SolicareCentralHomeHub::prompt_menu_selection()
 		set_tag_filter(SolicareHomeHub::Launcher::TAG);
 		log_info(SolicareHomeHub::Launcher::TAG, "로그 출력이 제한됩니다.", SolicareHomeHub::Launcher::LOG_COLOR);
 	}
+	flush(); // Queued log lines must not end up in the middle of the menu
 
 	constexpr int width = 40;
 	std::cout << string(width, '=') << std::endl;
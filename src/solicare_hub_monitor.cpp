@@ -74,18 +74,17 @@ void SolicareCentralHomeHub::on_menu_guardian_mode()
 			    // log_info(TAG, fmt::format("모니터링 상태 수신: {}", monitoring ? "true" : "false"), LOG_COLOR);
 			    if (const bool monitoring = fetch_monitoring_status(); prev_state != monitoring)
 			    {
-				    log_warn(TAG, fmt::format("보호자에 의해 모니터링 상태가 변경되었습니다: {} → {}",
-				                              prev_state ? "활성화" : "비활성화", monitoring ? "활성화" : "비활성화"));
+				    Logger::warn(TAG, "보호자에 의해 모니터링 상태가 변경되었습니다: {} → {}",
+				                 prev_state ? "활성화" : "비활성화", monitoring ? "활성화" : "비활성화");
 				    if (monitoring == true && !websocket_server_)
 				    {
-					    log_info(TAG,
-					             fmt::format("보호자 모니터링 활성화 → 비동기 웹소켓 서버를 {}번 포트에서 시작합니다.",
-					                         SolicareHomeHub::DEFAULT_WS_SERVER_PORT),
-					             LOG_COLOR);
+					    Logger::info(TAG, LOG_COLOR,
+					                 "보호자 모니터링 활성화 → 비동기 웹소켓 서버를 {}번 포트에서 시작합니다.",
+					                 SolicareHomeHub::DEFAULT_WS_SERVER_PORT);
 					    WebSocketServerContext::flag_stop_server             = false;
 					    WebSocketServerContext::ws_server_config.server_port = SolicareHomeHub::DEFAULT_WS_SERVER_PORT;
 					    WebSocketServerContext::ws_session_map.clear();
-					    websocket_server_ = make_shared<AsyncWebSocketServer>(ioc_);
+					    websocket_server_ = make_shared<AsyncWebSocketServer>(ioc_, *ws_io_context_pool_);
 					    websocket_server_->start();
 					    mode = SolicareHomeHub::ApiClient::FULL_MONITORING;
 					    start_monitoring();
@@ -95,7 +94,6 @@ void SolicareCentralHomeHub::on_menu_guardian_mode()
 					    log_info(TAG, "보호자 모니터링 중단 → 실행중인 비동기 웹소켓 서버를 중지합니다.", LOG_COLOR);
 					    stop_monitoring();
 					    websocket_server_->stop();
-					    this_thread::sleep_for(milliseconds(1000));
 					    websocket_server_.reset();
 				    }
 				    prev_state = monitoring;
@@ -108,7 +106,6 @@ void SolicareCentralHomeHub::on_menu_guardian_mode()
 		    {
 			    stop_monitoring();
 			    websocket_server_->stop();
-			    this_thread::sleep_for(milliseconds(1000));
 			    websocket_server_.reset();
 		    }
 	    });
@@ -161,9 +158,10 @@ void SolicareCentralHomeHub::start_monitoring()
                 bool wearable_detached = (wearable_gap > TIME_TO_WAIT_DATA) || (last_wear_gap > TIME_TO_WAIT_DATA);
 
                 // 테스트용 한 줄 로그 (기존 로그는 생략)
-                log_info(TAG, fmt::format("[TEST] camera_detached: {} | wearable_detached: {} | camera_gap: {}s | "
-			                                                                                                              "wearable_gap: {}s | last_wear_gap:	{}s ",
-			                                                                      camera_detached, wearable_detached, camera_gap, wearable_gap, last_wear_gap));
+                // Debug 빌드에서만 출력 (Release 에서는 컴파일 단계에서 제거됨)
+                debug(TAG, "[TEST] camera_detached: {} | wearable_detached: {} | camera_gap: {}s | wearable_gap: {}s | "
+                           "last_wear_gap: {}s",
+                      camera_detached, wearable_detached, camera_gap, wearable_gap, last_wear_gap);
 
                 // mode 결정 (둘 다 분리면 웨어러블만 분리로 간주)
                 if (camera_detached && wearable_detached)
@@ -203,10 +201,8 @@ void SolicareCentralHomeHub::start_monitoring()
                     }
                     else
                     {
-                        log_info(TAG,
-					                                                     fmt::format("[LOG] 카메라 분리 감지({}초 이내, {}초 경과). API 호출 생략.", 60,
-					                                                                 since_last_notify),
-					                                                     LOG_COLOR);
+                        Logger::info(TAG, LOG_COLOR, "[LOG] 카메라 분리 감지({}초 이내, {}초 경과). API 호출 생략.",
+                                     60, since_last_notify);
                     }
                 }
 
@@ -224,10 +220,8 @@ void SolicareCentralHomeHub::start_monitoring()
                     }
                     else
                     {
-                        log_info(TAG,
-					                                                     fmt::format("[LOG] 웨어러블 분리 감지({}초 이내, {}초 경과). API 호출 생략.", 60,
-					                                                                 since_last_notify),
-					                                                     LOG_COLOR);
+                        Logger::info(TAG, LOG_COLOR, "[LOG] 웨어러블 분리 감지({}초 이내, {}초 경과). API 호출 생략.",
+                                     60, since_last_notify);
                     }
                 }
                 // 이전 상태 갱신
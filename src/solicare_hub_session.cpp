@@ -1,4 +1,8 @@
 #include "solicare_central_home_hub.hpp"
+#include "utils/metrics.hpp"
+#include <algorithm>
+#include <magic_enum.hpp>
+#include <nlohmann/json.hpp>
 
 using namespace std;
 using namespace chrono;
@@ -8,151 +12,406 @@ using namespace WebSocketServerContext;
 using namespace SolicareHomeHub;
 using namespace SolicareHomeHub::SessionManager;
 
+namespace
+{
+constexpr auto DEVICE_TYPE_HEADER = "X-Device-Type";
+
+std::atomic_int admitted_sessions  = 0;
+std::atomic_int admitted_cameras   = 0;
+std::atomic_int admitted_wearables = 0;
+
+SESSION_TYPE identify_session_type(const std::string_view message)
+{
+	if (message.find("CAM") != string::npos)
+		return SESSION_CAMERA;
+	if (message.find("WEARABLE") != string::npos)
+		return SESSION_WEARABLE;
+	if (message.find("TEST") != string::npos)
+		return SESSION_TEST;
+	return SESSION_NOT_IDENTIFIED;
+}
+
+// Whether one of the ';'-separated fields of an identification message is exactly field, so "CAM_BACKDOOR" does
+// not ask for acknowledgements
+bool has_field(const std::string_view message, const std::string_view field)
+{
+	for (size_t start = 0; start <= message.size();)
+	{
+		const auto end = min(message.find(';', start), message.size());
+		if (message.substr(start, end - start) == field)
+			return true;
+		start = end + 1;
+	}
+	return false;
+}
+
+std::atomic_int* type_counter(const SESSION_TYPE type)
+{
+	switch (type)
+	{
+	case SESSION_CAMERA:
+		return &admitted_cameras;
+	case SESSION_WEARABLE:
+		return &admitted_wearables;
+	default:
+		return nullptr;
+	}
+}
+
+int type_limit(const SESSION_TYPE type)
+{
+	return type == SESSION_CAMERA ? ws_server_config.max_camera_session : ws_server_config.max_wearable_session;
+}
+
+bool try_increment(std::atomic_int& counter, const int limit) // limit <= 0: unlimited
+{
+	auto current = counter.load(memory_order_relaxed);
+	do
+	{
+		if (limit > 0 && current >= limit)
+			return false;
+	} while (!counter.compare_exchange_weak(current, current + 1, memory_order_relaxed));
+	return true;
+}
+} // namespace
+
+SessionManager::AdmissionSlot::~AdmissionSlot()
+{
+	admitted_sessions.fetch_sub(1, memory_order_relaxed);
+	if (auto* counter = type_counter(type))
+	{
+		counter->fetch_sub(1, memory_order_relaxed);
+	}
+}
+
+shared_ptr<AdmissionSlot> SessionManager::try_admit(const SESSION_TYPE type)
+{
+	if (!try_increment(admitted_sessions, ws_server_config.max_session))
+		return nullptr;
+	if (auto* counter = type_counter(type); counter && !try_increment(*counter, type_limit(type)))
+	{
+		admitted_sessions.fetch_sub(1, memory_order_relaxed);
+		return nullptr;
+	}
+	return make_shared<AdmissionSlot>(type);
+}
+
+bool SessionManager::try_assign_type(AdmissionSlot& slot, const SESSION_TYPE type)
+{
+	if (slot.type == type)
+		return true;
+	if (auto* counter = type_counter(type); counter && !try_increment(*counter, type_limit(type)))
+		return false;
+	if (auto* counter = type_counter(slot.type))
+	{
+		counter->fetch_sub(1, memory_order_relaxed);
+	}
+	slot.type = type;
+	return true;
+}
+
+AdmissionTicket WebSocketServerContext::on_session_admit(const UpgradeRequest& request, const string&)
+{
+	// Devices may announce their type before the upgrade ("ws://hub:3000/camera" or "X-Device-Type: CAM"), which
+	// enforces the per-type quota without a handshake. Otherwise only max_session applies until identification.
+	const auto header = request[DEVICE_TYPE_HEADER];
+	const auto target = request.target();
+	auto announced    = string(header.data(), header.size()) + ' ' + string(target.data(), target.size());
+	ranges::transform(announced, announced.begin(), [](const unsigned char c) { return toupper(c); });
+
+	// Rejections are only counted (see on_session_manage), logging each one would amplify a reconnect storm
+	return try_admit(identify_session_type(announced));
+}
+
 void WebSocketServerContext::on_session_created(const shared_ptr<Session>& session, const shared_ptr<Buffer>& buffer)
 {
-	const auto device_ip = session->ws->next_layer().remote_endpoint().address().to_string();
+	const auto& device_ip = session->device_ip;
 	if (!session->ws->got_text())
 	{
-		Logger::log_warn(
-		    TAG, fmt::format("Expected text message to identify device type, but received other {}", device_ip));
+		Logger::warn(TAG, "Expected text message to identify device type, but received other {}", device_ip);
 		return;
 	}
 
 	const auto message = buffers_to_string(buffer->data());
-	Logger::log_info(TAG, fmt::format("[Created] New session: device_ip={} | message={}", device_ip, message),
-	                 LOG_COLOR);
-
-	// TODO: send same message back to the device to confirm connection established
-	// ws->text(true);
-	// ws->async_write(buffer->data(),
-	//                 [](const boost::system::error_code& ec, std::size_t bytes_transferred)
-	//                 {
-	//                     if (ec)
-	//                     {
-	//                         error(TAG, fmt::format("[Session] Error sending confirmation message: {}",
-	//                         ec.message()));
-	//                     }
-	//                 });
+	const auto type    = identify_session_type(message);
+	if (const auto slot = static_pointer_cast<AdmissionSlot>(session->admission);
+	    slot && !try_assign_type(*slot, type))
+	{
+		Logger::warn(TAG, "[Admission] Refused {} from {}: session quota reached", magic_enum::enum_name(type),
+		             device_ip);
+		session->admission.reset();
+		return;
+	}
+	Logger::info(TAG, LOG_COLOR, "[Created] New session: device_ip={} | message={}", device_ip, message);
+
+	// Echo the identification message back to confirm the connection (and the negotiated protocol), a device of an
+	// unknown type is not confirmed
+	if (type != SESSION_NOT_IDENTIFIED && !session->outbound->send(message, true, "confirm"))
+	{
+		Logger::warn(TAG, "Could not queue connection confirmation for {}", device_ip);
+	}
 
 	session->info                           = make_shared<SessionInfo>();
 	session->info->timepoint_connected      = steady_clock::now();
 	session->info->timepoint_last_received  = steady_clock::now();
 	session->info->timepoint_last_processed = steady_clock::now();
-	if (message.find("CAM") != string::npos)
+	if (has_field(message, ACK_TOKEN))
+	{
+		session->info->ack_queue = session->outbound;
+	}
+	if (type == SESSION_CAMERA)
 	{
 		session->info->type     = SESSION_CAMERA;
-		session->info->data     = make_shared<CameraProcessor::CameraSessionData>();
-		const auto camera_data  = get<shared_ptr<CameraProcessor::CameraSessionData>>(session->info->data);
-		camera_data->device_tag = fmt::format("{}({})", message, device_ip);
+		session->info->data     = make_shared<CameraProcessor::CameraSessionState>();
+		const auto camera       = get<shared_ptr<CameraProcessor::CameraSessionState>>(session->info->data);
+		camera->data.device_tag = fmt::format("{}({})", message, device_ip);
+		camera->motion_gate.configure(CameraProcessor::motion_gate_config_for(message));
+		camera->keypoint_tracker.configure(CameraProcessor::keypoint_tracker_config);
+		camera->inference_region.configure(CameraProcessor::inference_region_config);
 	}
-	else if (message.find("WEARABLE") != string::npos)
+	else if (type == SESSION_WEARABLE)
 	{
 		session->info->type = SESSION_WEARABLE;
 		session->info->data = make_shared<WearableProcessor::WearableSessionData>();
+		if (message.find(WearableProcessor::PROTOCOL_BINARY_V1_TOKEN) != string::npos)
+		{
+			get<shared_ptr<WearableProcessor::WearableSessionData>>(session->info->data)->protocol =
+			    WearableProcessor::PROTOCOL_BINARY_V1;
+		}
 	}
-	else if (message.find("TEST") != string::npos)
+	else if (type == SESSION_TEST)
 	{
 		session->info->type = SESSION_TEST;
 		session->info->data = message;
 	}
 	else
 	{
-		Logger::log_warn(TAG, fmt::format("Unknown device type received: '{}' from {}", message, device_ip));
+		Logger::warn(TAG, "Unknown device type received: '{}' from {}", message, device_ip);
 	}
 }
 
 void WebSocketServerContext::on_session_read(const shared_ptr<Session>& session, const shared_ptr<Buffer>& buffer)
 {
+	static auto& camera_frames   = Metrics::registry().counter("solicare_frames_received_total",
+	                                                           "Frames received from devices", R"(type="camera")");
+	static auto& wearable_frames = Metrics::registry().counter("solicare_frames_received_total",
+	                                                           "Frames received from devices", R"(type="wearable")");
+	static auto& camera_bytes    = Metrics::registry().counter("solicare_bytes_received_total",
+	                                                           "Bytes received from devices", R"(type="camera")");
+	static auto& wearable_bytes  = Metrics::registry().counter("solicare_bytes_received_total",
+	                                                           "Bytes received from devices", R"(type="wearable")");
+
 	session->info->timepoint_last_received = steady_clock::now();
+	const auto sequence                    = session->info->frames_received.fetch_add(1, memory_order_relaxed) + 1;
+	session->info->bytes_received.fetch_add(buffer->size(), memory_order_relaxed);
+	if (session->info->type == SESSION_CAMERA)
+	{
+		camera_frames.add();
+		camera_bytes.add(buffer->size());
+	}
+	else if (session->info->type == SESSION_WEARABLE)
+	{
+		wearable_frames.add();
+		wearable_bytes.add(buffer->size());
+	}
 	if (session->info->type == SESSION_CAMERA &&
-	    holds_alternative<shared_ptr<CameraProcessor::CameraSessionData>>(session->info->data))
+	    holds_alternative<shared_ptr<CameraProcessor::CameraSessionState>>(session->info->data))
 	{
-		SolicareCentralHomeHub::process_image(session->info, buffer);
+		// Processed on the camera worker pool, which also updates timepoint_last_processed
+		SolicareCentralHomeHub::submit_image(session->info, {buffer, sequence});
+		return;
 	}
 	else if (session->info->type == SESSION_WEARABLE &&
 	         holds_alternative<shared_ptr<WearableProcessor::WearableSessionData>>(session->info->data))
 	{
-		SolicareCentralHomeHub::process_wearable(session->info, buffer);
+		SolicareCentralHomeHub::process_wearable(session->info, buffer, session->ws->got_text());
 	}
 	else if (session->info->type == SESSION_TEST && holds_alternative<std::string>(session->info->data))
 	{
 		const auto session_tag = get<string>(session->info->data);
-		Logger::log_info(TAG, fmt::format("[Receive] '{}' sent: {}", session_tag, buffers_to_string(buffer->data())),
-		                 LOG_COLOR);
+		Logger::info(TAG, LOG_COLOR, "[Receive] '{}' sent: {}", session_tag, buffers_to_string(buffer->data()));
 	}
 	else
 	{
-		const auto device_ip = session->ws->next_layer().remote_endpoint().address().to_string();
-		Logger::log_warn(
-		    TAG, fmt::format("Received data for unsupported session type or uninitialized session from {}", device_ip));
+		Logger::warn(TAG, "Received data for unsupported session type or uninitialized session from {}",
+		             session->device_ip);
 		return;
 	}
 	session->info->timepoint_last_processed = steady_clock::now();
+	session->info->acknowledge(sequence);
+}
+
+void SessionInfo::acknowledge(const uint64_t sequence) const
+{
+	if (ack_queue)
+	{
+		ack_queue->send(fmt::format("{{\"ack\":{}}}", sequence));
+	}
+}
+
+void WebSocketServerContext::on_session_closed(const shared_ptr<Session>& session)
+{
+	session->info->timepoint_disconnected = steady_clock::now();
+	if (const auto* camera = get_if<shared_ptr<CameraProcessor::CameraSessionState>>(&session->info->data))
+	{
+		Logger::info(TAG, LOG_COLOR,
+		             "[Remove] camera '{}': {} frame(s) received, {} dropped by the mailbox, {:.0f}% not inferred, {} "
+		             "tracked.",
+		             (*camera)->data.device_tag, (*camera)->mailbox.posted(), (*camera)->mailbox.dropped(),
+		             100.0 * (*camera)->motion_gate.skip_ratio(), (*camera)->keypoint_tracker.tracked());
+		// Frames still in flight see timepoint_disconnected and are not published anymore
+		if (auto& compositor = CameraProcessor::display_compositor)
+			compositor->close((*camera)->data.device_tag);
+	}
+	Logger::info(TAG, LOG_COLOR, "[Remove] session '{}' had been removed.", session->device_ip);
 }
 
+namespace
+{
+// Asks cameras whose frames mostly got replaced in the mailbox since the last call to send fewer, the hub spends
+// their decode and upload on frames it never processes
+void request_lower_camera_fps()
+{
+	vector<string> overloaded;
+	ws_session_map.cvisit_all(
+	    [&overloaded](const auto& pair)
+	    {
+		    const auto& info   = pair.second->info;
+		    const auto* camera = info ? get_if<shared_ptr<CameraProcessor::CameraSessionState>>(&info->data) : nullptr;
+		    if (!camera)
+			    return;
+		    auto& state         = **camera;
+		    const auto posted   = state.mailbox.posted();
+		    const auto dropped  = state.mailbox.dropped();
+		    const auto received = posted - exchange(state.posted_at_last_check, posted);
+		    const auto replaced = dropped - exchange(state.dropped_at_last_check, dropped);
+		    if (received > 0 && replaced * 2 > received)
+			    overloaded.push_back(pair.first);
+	    });
+	// Sent outside the visit, send_device_command() visits the map itself
+	for (const auto& device : overloaded)
+	{
+		SolicareHomeHub::SessionManager::send_device_command(device, string(LOWER_FPS_COMMAND));
+	}
+}
+} // namespace
+
 void WebSocketServerContext::on_session_manage()
 {
-	if (!ws_session_map.empty())
+	request_lower_camera_fps();
+	const auto [hits, misses, discarded, pooled] = ws_buffer_pool.load()->stats();
+	Logger::info(TAG, Logger::ConsoleColor::WHITE,
+	             "active sessions: {} | admitted: {} (cameras={}, wearables={}), rejected={} | "
+	             "buffer pool: hits={}, misses={}, discarded={}, pooled={}",
+	             ws_session_map.size(), admitted_sessions.load(), admitted_cameras.load(), admitted_wearables.load(),
+	             ws_rejected_connections.load(), hits, misses, discarded, pooled);
+}
+
+bool SolicareHomeHub::SessionManager::send_device_command(const string& device_id, const string& command,
+                                                          const string& argument)
+{
+	nlohmann::json payload = {{"command", command}};
+	if (!argument.empty())
 	{
-		vector<string> sessions_to_remove;
-		sessions_to_remove.reserve(ws_session_map.size());
-		ws_session_map.cvisit_all(
-		    [&](const auto& pair)
-		    {
-			    const auto& device_ip = pair.first;
-			    const auto& session   = pair.second;
-
-			    if (!session || !session->info)
-			    {
-				    sessions_to_remove.push_back(device_ip);
-				    return;
-			    }
-
-			    const auto now = steady_clock::now();
-			    const auto time_since_connected =
-			        duration_cast<seconds>(now - session->info->timepoint_connected).count();
-			    const auto time_since_last_received =
-			        duration_cast<seconds>(now - session->info->timepoint_last_received).count();
-
-			    if (session->ws && session->ws->is_open() && session->ws->next_layer().is_open())
-			    {
-				    if (time_since_connected > ws_server_config.session_timeout &&
-				        time_since_last_received > ws_server_config.session_timeout)
-				    {
-					    Logger::log_warn(
-					        TAG, fmt::format(
-					                 "[Timeout] session '{}' will be disconnected by timeout (last received: {}s ago)",
-					                 device_ip, time_since_last_received));
-					    session->ws->async_close(
-					        websocket::close_code::normal,
-					        [device_ip](const boost::system::error_code& ec)
-					        {
-						        if (ec)
-						        {
-							        Logger::log_error(TAG, fmt::format("Error closing websocket for session '{}': {}",
-							                                           device_ip, ec.message()));
-						        }
-					        });
-					    sessions_to_remove.push_back(device_ip);
-				    }
-			    }
-			    else
-			    {
-				    log_info(TAG, fmt::format("[Disconnect] session '{}' had been disconnect.", device_ip), LOG_COLOR);
-				    sessions_to_remove.push_back(device_ip);
-			    }
-		    });
-
-		for (const auto& device_ip : sessions_to_remove)
-		{
-			Logger::log_info(TAG, fmt::format("[Remove] session '{}' had been removed.", device_ip), LOG_COLOR);
-			ws_session_map.erase(device_ip);
-		}
+		payload["argument"] = argument;
 	}
 
-	if (const auto now = steady_clock::now(); duration_cast<seconds>(now - ws_last_session_logged).count() >= 10)
+	bool queued      = false;
+	const auto found = ws_session_map.cvisit(device_id, [&](const auto& pair)
+	                                         { queued = pair.second->outbound->send(payload.dump(), true, command); });
+	if (found == 0)
+	{
+		Logger::warn(TAG, "[Command] '{}' not sent: device {} is not connected", command, device_id);
+	}
+	else if (!queued)
 	{
-		Logger::log_info(TAG, fmt::format("active sessions: {}", ws_session_map.size()), Logger::ConsoleColor::WHITE);
-		ws_last_session_logged = now;
+		Logger::warn(TAG, "[Command] '{}' dropped: outbound queue of {} is full", command, device_id);
 	}
+	return queued;
+}
+
+void SolicareHomeHub::SessionManager::register_metrics()
+{
+	auto& registry = Metrics::registry();
+	registry.gauge("solicare_sessions", "Identified sessions",
+	               [] { return static_cast<double>(ws_session_map.size()); });
+	registry.gauge("solicare_admitted_connections", "Connections holding an admission slot",
+	               [] { return static_cast<double>(admitted_sessions.load()); });
+	registry.gauge("solicare_admitted_connections_by_type", "Admission slots held per device type",
+	               [] { return static_cast<double>(admitted_cameras.load()); }, R"(type="camera")");
+	registry.gauge("solicare_admitted_connections_by_type", "Admission slots held per device type",
+	               [] { return static_cast<double>(admitted_wearables.load()); }, R"(type="wearable")");
+	registry.sampled_counter("solicare_rejected_connections_total", "Connections rejected before the WebSocket upgrade",
+	                         [] { return static_cast<double>(ws_rejected_connections.load()); });
+	registry.gauge("solicare_camera_data_queue_depth", "Camera results waiting for the monitor",
+	               [] { return static_cast<double>(Monitor::camera_data_queue.unsafe_size()); });
+	registry.gauge("solicare_wearable_data_queue_depth", "Wearable results waiting for the monitor",
+	               [] { return static_cast<double>(Monitor::wearable_data_queue.unsafe_size()); });
+	registry.gauge("solicare_buffer_pool_pooled", "Receive buffers ready for reuse",
+	               []
+	               {
+		               const auto pool = ws_buffer_pool.load();
+		               return pool ? static_cast<double>(pool->stats().pooled) : 0.0;
+	               });
+
+	// One series per connection, bounded by max_session; device is the connection's id, so devices behind one
+	// address (NAT, a load generator) keep separate series
+	registry.collector(
+	    [](string& out)
+	    {
+		    string frames, bytes, dropped, gated, skipped, tracked;
+		    ws_session_map.cvisit_all(
+		        [&](const auto& pair)
+		        {
+			        const auto& info  = *pair.second->info;
+			        const auto labels = fmt::format(R"(device="{}",type="{}")", pair.first,
+			                                        magic_enum::enum_name(info.type));
+			        frames += fmt::format("solicare_session_frames_received_total{{{}}} {}\n", labels,
+			                              info.frames_received.load(memory_order_relaxed));
+			        bytes += fmt::format("solicare_session_bytes_received_total{{{}}} {}\n", labels,
+			                             info.bytes_received.load(memory_order_relaxed));
+			        if (const auto* camera = get_if<shared_ptr<CameraProcessor::CameraSessionState>>(&info.data))
+			        {
+				        dropped += fmt::format("solicare_session_frames_dropped_total{{{}}} {}\n", labels,
+				                               (*camera)->mailbox.dropped());
+				        gated += fmt::format("solicare_camera_gated_frames_total{{{}}} {}\n", labels,
+				                             (*camera)->motion_gate.evaluated());
+				        skipped += fmt::format("solicare_camera_inference_skipped_total{{{}}} {}\n", labels,
+				                               (*camera)->motion_gate.skipped());
+				        tracked += fmt::format("solicare_camera_tracked_frames_total{{{}}} {}\n", labels,
+				                               (*camera)->keypoint_tracker.tracked());
+			        }
+		        });
+		    out += "# HELP solicare_session_frames_received_total Frames received per connected device\n"
+		           "# TYPE solicare_session_frames_received_total counter\n" +
+		           frames;
+		    out += "# HELP solicare_session_bytes_received_total Bytes received per connected device\n"
+		           "# TYPE solicare_session_bytes_received_total counter\n" +
+		           bytes;
+		    out += "# HELP solicare_session_frames_dropped_total Camera frames replaced before processing\n"
+		           "# TYPE solicare_session_frames_dropped_total counter\n" +
+		           dropped;
+		    out += "# HELP solicare_camera_gated_frames_total Camera frames checked by the motion gate\n"
+		           "# TYPE solicare_camera_gated_frames_total counter\n" +
+		           gated;
+		    out += "# HELP solicare_camera_inference_skipped_total Camera frames that skipped the pose model\n"
+		           "# TYPE solicare_camera_inference_skipped_total counter\n" +
+		           skipped;
+		    out += "# HELP solicare_camera_tracked_frames_total Camera frames followed by the keypoint tracker instead "
+		           "of the pose model\n"
+		           "# TYPE solicare_camera_tracked_frames_total counter\n" +
+		           tracked;
+		    if (const auto& compositor = CameraProcessor::display_compositor)
+		    {
+			    out += fmt::format("# HELP solicare_display_frames_shown_total Camera frames drawn by the display\n"
+			                       "# TYPE solicare_display_frames_shown_total counter\n"
+			                       "solicare_display_frames_shown_total {}\n",
+			                       compositor->shown());
+			    out += fmt::format("# HELP solicare_display_frames_replaced_total Camera frames replaced by a newer "
+			                       "one before the display refreshed\n"
+			                       "# TYPE solicare_display_frames_replaced_total counter\n"
+			                       "solicare_display_frames_replaced_total {}\n",
+			                       compositor->replaced());
+		    }
+	    });
 }
@@ -1,43 +1,97 @@
 #include "solicare_central_home_hub.hpp"
+#include "utils/binary_utils.hpp"
 #include "utils/json_utils.hpp"
+#include "utils/metrics.hpp"
 
 using namespace std;
 using namespace chrono;
 using namespace SolicareHomeHub::WearableProcessor;
 
+namespace
+{
+// Decodes a binary v1 frame directly from the receive buffer, returns false if it is not a valid v1 frame
+bool decode_binary_frame_v1(const WebSocketServerContext::Buffer& buffer, WearableSessionData& data)
+{
+	using namespace BinaryFrameV1;
+	using BinaryUtils::read_le;
+
+	if (buffer.size() < SIZE)
+		return false;
+	const auto* frame = static_cast<const std::byte*>(buffer.data().data());
+	if (read_le<uint8_t>(frame + OFFSET_TYPE) != TYPE_TELEMETRY || read_le<uint8_t>(frame + OFFSET_VERSION) != VERSION)
+		return false;
+
+	const auto flags         = read_le<uint16_t>(frame + OFFSET_FLAGS);
+	data.is_wearing          = (flags & FLAG_WEARING) != 0;
+	data.is_fall_detected    = (flags & FLAG_FALL_DETECTED) != 0;
+	data.sequence            = read_le<uint32_t>(frame + OFFSET_SEQUENCE);
+	data.device_timestamp_ms = read_le<uint64_t>(frame + OFFSET_TIMESTAMP);
+	data.heart_rate_bpm      = read_le<float>(frame + OFFSET_BPM);
+	data.body_temperature    = read_le<float>(frame + OFFSET_TEMP);
+	data.air_humidity        = read_le<float>(frame + OFFSET_HUMIDITY);
+	data.battery_percentage  = read_le<float>(frame + OFFSET_BATTERY);
+	return true;
+}
+
+// Legacy JSON telemetry, still accepted from every wearable as a fallback
+bool decode_json(const WebSocketServerContext::Buffer& buffer, WearableSessionData& data)
+{
+	const std::string texted_json = boost::beast::buffers_to_string(buffer.data());
+	const auto parsed             = JsonUtils::parse_json(texted_json);
+	if (!parsed)
+	{
+		Logger::error(TAG, "JSON parsing failed, Received: {}", texted_json);
+		return false;
+	}
+	const auto& j = parsed.value();
+	if (j.contains("status"))
+		data.is_wearing = (j["status"].get<std::string>() == "ON");
+	if (j.contains("fall_detected"))
+		data.is_fall_detected = j["fall_detected"].get<bool>();
+	if (j.contains("bpm"))
+		data.heart_rate_bpm = j["bpm"].get<double>();
+	if (j.contains("temperature"))
+		data.body_temperature = j["temperature"].get<double>();
+	if (j.contains("humidity"))
+		data.air_humidity = j["humidity"].get<double>();
+	if (j.contains("voltage"))
+		data.battery_percentage = j["voltage"].get<double>();
+	return true;
+}
+} // namespace
+
 void SolicareCentralHomeHub::process_wearable(const std::shared_ptr<WebSocketServerContext::SessionInfo>& session_info,
-                                              const std::shared_ptr<WebSocketServerContext::Buffer>& buffer)
+                                              const std::shared_ptr<WebSocketServerContext::Buffer>& buffer,
+                                              const bool is_text)
 {
+	static auto& process_seconds = Metrics::registry().histogram(
+	    "solicare_frame_process_seconds", "Time spent processing one frame", R"(type="wearable")");
+	const Metrics::ScopedTimer process_timer(process_seconds);
 	try
 	{
-		const auto& data        = get<shared_ptr<WearableSessionData>>(session_info->data);
-		std::string texted_json = boost::beast::buffers_to_string(buffer->data());
-
-		const auto parsed = JsonUtils::parse_json(texted_json);
-		if (!parsed)
+		const auto& data = get<shared_ptr<WearableSessionData>>(session_info->data);
+		if (is_text)
+		{
+			if (!decode_json(*buffer, *data))
+				return;
+		}
+		else if (data->protocol == PROTOCOL_BINARY_V1)
+		{
+			if (!decode_binary_frame_v1(*buffer, *data))
+			{
+				Logger::error(TAG, "Invalid binary telemetry frame ({} bytes)", buffer->size());
+				return;
+			}
+		}
+		else
 		{
-			Logger::log_error(TAG, fmt::format("JSON parsing failed, Received: {}", texted_json));
+			Logger::log_warn(TAG, "Binary telemetry received, but the binary protocol was not negotiated.");
 			return;
 		}
-		const auto& j = parsed.value();
-		if (j.contains("status"))
-			data->is_wearing = (j["status"].get<std::string>() == "ON");
-		if (j.contains("fall_detected"))
-			data->is_fall_detected = j["fall_detected"].get<bool>();
-		if (j.contains("bpm"))
-			data->heart_rate_bpm = j["bpm"].get<double>();
-		if (j.contains("temperature"))
-			data->body_temperature = j["temperature"].get<double>();
-		if (j.contains("humidity"))
-			data->air_humidity = j["humidity"].get<double>();
-		if (j.contains("voltage"))
-			data->battery_percentage = j["voltage"].get<double>();
-
-		Logger::log_info(TAG,
-		                 fmt::format("[WEARABLE] wear:{}, fall:{}, bpm:{} bpm, temp:{}℃, hum:{}%, volt:{}%",
-		                             data->is_wearing, data->is_fall_detected, data->heart_rate_bpm,
-		                             data->body_temperature, data->air_humidity, data->battery_percentage),
-		                 LOG_COLOR);
+
+		Logger::info(TAG, LOG_COLOR, "[WEARABLE] wear:{}, fall:{}, bpm:{} bpm, temp:{}℃, hum:{}%, volt:{}%",
+		             data->is_wearing, data->is_fall_detected, data->heart_rate_bpm, data->body_temperature,
+		             data->air_humidity, data->battery_percentage);
 
 		// push SessionData to wearable_data_queue for monitoring (Copy)
 		SolicareHomeHub::Monitor::wearable_data_queue.push(*data);
@@ -45,7 +99,7 @@ void SolicareCentralHomeHub::process_wearable(const std::shared_ptr<WebSocketSer
 	}
 	catch (const std::exception& e)
 	{
-		Logger::log_error(TAG, fmt::format("Exception in process_wearable: {}", e.what()));
+		Logger::error(TAG, "Exception in process_wearable: {}", e.what());
 	}
 	catch (...)
 	{
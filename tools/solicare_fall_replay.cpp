@@ -0,0 +1,346 @@
+// Fall detector replay: runs FallDetector over keypoint sequences and checks that falls, and only falls, are reported.
+//
+// Usage:
+//   solicare_fall_replay [--sequences <directory>] [--no-synthetic] [--verbose]
+//
+// Built-in synthetic scenarios (standing, sitting down, lying down slowly, falls with and without getting up) are
+// always replayed unless --no-synthetic is given. Recorded sequences are CSV files, one frame per line:
+//   time_ms,box_x,box_y,box_w,box_h,x0,y0,c0,...,x16,y16,c16   (frame pixels, COCO keypoint order)
+//   time_ms                                                  (frame without a person)
+// Lines starting with '#' are ignored. A file named *.fall.csv must reach FALLEN, any other *.csv must not. A file
+// that cannot be parsed is skipped with a warning.
+// The exit code is the number of sequences whose outcome did not match. ctest runs the synthetic ones together with
+// tools/keypoint_sequences as fall_replay.
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fmt/core.h>
+#include <fstream>
+#include <numbers>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "utils/logging_utils.hpp"
+#include "vision/fall_detector.hpp"
+#include "vision/keypoint_history.hpp"
+#include "vision/pose_model.hpp"
+
+using namespace std;
+using namespace chrono;
+
+namespace
+{
+constexpr std::string_view TAG = "FallReplay";
+constexpr auto LOG_COLOR       = Logger::ConsoleColor::LIME;
+
+constexpr double SYNTHETIC_FPS        = 15.0;
+constexpr std::size_t HISTORY_FRAMES = 30; // CameraProcessor::MAX_BODY_POINT
+
+struct Frame
+{
+	milliseconds time;
+	optional<PoseModel::PoseDetection> person;
+};
+
+struct Sequence
+{
+	string name;
+	bool expect_fall = false;
+	optional<BODY_POSTURE> expect_final; // Checked when set
+	vector<Frame> frames;
+};
+
+// Body pose of a synthetic scenario at one instant, interpolated between keyframes
+struct Keyframe
+{
+	double time;   // Seconds
+	float hip_y;   // Frame pixels
+	float angle;   // Degrees, 0 upright, 90 lying with the head to the right
+	float sitting; // 0 legs straight along the body, 1 thighs horizontal
+	bool visible = true;
+};
+
+// Stick figure around the hip centre: u across the body, v along it (head at negative v), in torso lengths
+PoseModel::PoseDetection synthetic_person(const Keyframe& pose, mt19937& random)
+{
+	constexpr float HIP_X = 480.0f, TORSO = 100.0f;
+	struct Offset
+	{
+		float u, v;
+	};
+	const auto legs = [&pose](const float side, const bool knee)
+	{
+		const Offset straight = knee ? Offset{side * 0.15f, 0.9f} : Offset{side * 0.15f, 1.8f};
+		const Offset sitting  = knee ? Offset{side * 0.15f + 0.8f, 0.1f} : Offset{side * 0.15f + 0.8f, 1.0f};
+		return Offset{straight.u + pose.sitting * (sitting.u - straight.u),
+		              straight.v + pose.sitting * (sitting.v - straight.v)};
+	};
+	const array<Offset, PoseModel::KEYPOINT_COUNT> body = {{{0.0f, -1.4f},
+	                                                        {0.08f, -1.45f},
+	                                                        {-0.08f, -1.45f},
+	                                                        {0.15f, -1.4f},
+	                                                        {-0.15f, -1.4f},
+	                                                        {0.25f, -1.0f},
+	                                                        {-0.25f, -1.0f},
+	                                                        {0.3f, -0.55f},
+	                                                        {-0.3f, -0.55f},
+	                                                        {0.3f, -0.1f},
+	                                                        {-0.3f, -0.1f},
+	                                                        {0.15f, 0.0f},
+	                                                        {-0.15f, 0.0f},
+	                                                        legs(1.0f, true),
+	                                                        legs(-1.0f, true),
+	                                                        legs(1.0f, false),
+	                                                        legs(-1.0f, false)}};
+
+	normal_distribution<float> noise(0.0f, 1.5f);
+	const float radians = pose.angle * numbers::pi_v<float> / 180.0f;
+	const float cosine = cos(radians), sine = sin(radians);
+	PoseModel::PoseDetection person;
+	float left = 1e9f, top = 1e9f, right = -1e9f, bottom = -1e9f;
+	for (int k = 0; k < PoseModel::KEYPOINT_COUNT; ++k)
+	{
+		const auto [u, v] = body[k];
+		const float x     = HIP_X + TORSO * (u * cosine - v * sine) + noise(random);
+		const float y     = pose.hip_y + TORSO * (u * sine + v * cosine) + noise(random);
+		person.keypoints[k]  = {x, y};
+		person.confidence[k] = 0.9f;
+		left   = min(left, x);
+		top    = min(top, y);
+		right  = max(right, x);
+		bottom = max(bottom, y);
+	}
+	constexpr float MARGIN = 15.0f;
+	person.box   = cv::Rect2f(left - MARGIN, top - MARGIN, right - left + 2 * MARGIN, bottom - top + 2 * MARGIN);
+	person.score = 0.9f;
+	return person;
+}
+
+Sequence synthetic(string name, const bool expect_fall, const BODY_POSTURE expect_final,
+                   const vector<Keyframe>& keyframes)
+{
+	Sequence sequence{std::move(name), expect_fall, expect_final, {}};
+	mt19937 random(7);
+	const double end = keyframes.back().time;
+	for (double t = 0.0; t <= end; t += 1.0 / SYNTHETIC_FPS)
+	{
+		const auto next = ranges::find_if(keyframes, [t](const Keyframe& keyframe) { return keyframe.time >= t; });
+		Keyframe pose   = *next;
+		if (next != keyframes.begin() && next->time > t)
+		{
+			const auto& previous = *(next - 1);
+			const auto blend     = static_cast<float>((t - previous.time) / (next->time - previous.time));
+			pose.hip_y   = previous.hip_y + blend * (next->hip_y - previous.hip_y);
+			pose.angle   = previous.angle + blend * (next->angle - previous.angle);
+			pose.sitting = previous.sitting + blend * (next->sitting - previous.sitting);
+			pose.visible = previous.visible;
+		}
+		Frame frame{duration_cast<milliseconds>(duration<double>(t)), nullopt};
+		if (pose.visible)
+			frame.person = synthetic_person(pose, random);
+		sequence.frames.push_back(std::move(frame));
+	}
+	return sequence;
+}
+
+// Standing hip height 300, sitting 350, on the floor 470; a bed is at 420
+vector<Sequence> synthetic_sequences()
+{
+	vector<Sequence> sequences;
+	sequences.push_back(synthetic("standing still", false, POSTURE_STANDING, {{0.0, 300, 0, 0}, {10.0, 300, 0, 0}}));
+	sequences.push_back(synthetic("sitting down", false, POSTURE_SITTING,
+	                              {{0.0, 300, 0, 0}, {2.0, 300, 0, 0}, {3.0, 350, 0, 1}, {10.0, 350, 0, 1}}));
+	sequences.push_back(synthetic("lying down slowly", false, POSTURE_LYING,
+	                              {{0.0, 300, 0, 0},
+	                               {2.0, 300, 0, 0},
+	                               {3.5, 350, 0, 1},
+	                               {5.5, 350, 0, 1},
+	                               {8.5, 420, 90, 0},
+	                               {14.0, 420, 90, 0}}));
+	sequences.push_back(synthetic("fall", true, POSTURE_FALLEN,
+	                              {{0.0, 300, 0, 0}, {3.0, 300, 0, 0}, {3.6, 470, 90, 0}, {10.0, 470, 90, 0}}));
+	sequences.push_back(synthetic("fall then getting up", true, POSTURE_STANDING,
+	                              {{0.0, 300, 0, 0},
+	                               {3.0, 300, 0, 0},
+	                               {3.6, 470, 90, 0},
+	                               {7.0, 470, 90, 0},
+	                               {9.0, 350, 0, 1},
+	                               {10.0, 300, 0, 0},
+	                               {13.0, 300, 0, 0}}));
+	sequences.push_back(synthetic("fall out of view", true, POSTURE_FALLEN,
+	                              {{0.0, 300, 0, 0},
+	                               {3.0, 300, 0, 0},
+	                               {3.6, 470, 90, 0},
+	                               {6.5, 470, 90, 0, false},
+	                               {15.0, 470, 90, 0, false}}));
+	sequences.push_back(synthetic("lying down briefly after a stumble", false, POSTURE_STANDING,
+	                              {{0.0, 300, 0, 0},
+	                               {3.0, 300, 0, 0},
+	                               {3.6, 470, 90, 0},
+	                               {4.2, 470, 90, 0},
+	                               {5.5, 300, 0, 0},
+	                               {9.0, 300, 0, 0}}));
+	return sequences;
+}
+
+optional<Sequence> load_sequence(const filesystem::path& path)
+{
+	ifstream file(path);
+	if (!file)
+		return nullopt;
+	const string file_name = path.filename().string();
+	Sequence sequence{file_name, file_name.ends_with(".fall.csv"), nullopt, {}};
+
+	string line;
+	for (int number = 1; getline(file, line); ++number)
+	{
+		if (line.empty() || line.front() == '#')
+			continue;
+		vector<float> values;
+		istringstream fields(line);
+		string field;
+		while (getline(fields, field, ','))
+		{
+			// Surrounding blanks and the CR of CRLF files are allowed, anything else makes the file unreadable
+			const auto first  = field.find_first_not_of(" \t\r");
+			const auto last   = field.find_last_not_of(" \t\r");
+			const char* begin = field.data() + (first == string::npos ? 0 : first);
+			const char* end   = field.data() + (last == string::npos ? 0 : last + 1);
+			float value       = 0.0f;
+			if (const auto [parsed, error] = from_chars(begin, end, value); error != errc{} || parsed != end)
+			{
+				Logger::log_warn(TAG, fmt::format("{}:{}: '{}' is not a number", file_name, number, field));
+				return nullopt;
+			}
+			values.push_back(value);
+		}
+		if (values.size() != 1 && values.size() != 5 + 3 * PoseModel::KEYPOINT_COUNT)
+		{
+			Logger::log_warn(TAG, fmt::format("{}:{}: expected 1 or {} values, got {}", file_name, number,
+			                                  5 + 3 * PoseModel::KEYPOINT_COUNT, values.size()));
+			return nullopt;
+		}
+		Frame frame{milliseconds(static_cast<long long>(values[0])), nullopt};
+		if (values.size() > 1)
+		{
+			PoseModel::PoseDetection person;
+			person.box   = cv::Rect2f(values[1], values[2], values[3], values[4]);
+			person.score = 1.0f;
+			for (int k = 0; k < PoseModel::KEYPOINT_COUNT; ++k)
+			{
+				person.keypoints[k]  = {values[5 + 3 * k], values[6 + 3 * k]};
+				person.confidence[k] = values[7 + 3 * k];
+			}
+			frame.person = person;
+		}
+		sequence.frames.push_back(std::move(frame));
+	}
+	return sequence;
+}
+
+// Replays one sequence, returns whether its outcome matched
+bool replay(const Sequence& sequence, const bool verbose)
+{
+	FallDetector detector;
+	KeypointHistory<HISTORY_FRAMES> history;
+	const FallDetector::Clock::time_point start{};
+	optional<milliseconds> first_fall;
+	BODY_POSTURE previous = POSTURE_UNKNOWN;
+	for (const auto& frame : sequence.frames)
+	{
+		// Offset from the clock's epoch, a default constructed time point means "not set" to the detector
+		const auto timestamp = start + hours(1) + frame.time;
+		if (frame.person)
+		{
+			history.push(*frame.person, timestamp);
+			detector.update(history.window());
+		}
+		else
+			detector.update_missing(timestamp);
+
+		if (detector.posture() == POSTURE_FALLEN && !first_fall)
+			first_fall = frame.time;
+		if (verbose && detector.posture() != previous)
+			Logger::log_info(TAG, fmt::format("  {:>7.2f}s {} -> {} (speed {:.2f}, angle {:.0f}, aspect {:.2f})",
+			                                  duration<double>(frame.time).count(), to_string(previous),
+			                                  to_string(detector.posture()), detector.vertical_speed(),
+			                                  detector.torso_angle(), detector.aspect_ratio()));
+		previous = detector.posture();
+	}
+
+	const bool fall_matches  = first_fall.has_value() == sequence.expect_fall;
+	const bool final_matches = !sequence.expect_final || detector.posture() == *sequence.expect_final;
+	const auto outcome       = first_fall ? fmt::format("fall at {:.2f}s", duration<double>(*first_fall).count())
+	                                      : string("no fall");
+	const auto message = fmt::format("{:<36} {:<4} {:<16} final {:<8} ({} frames)", sequence.name,
+	                                 fall_matches && final_matches ? "ok" : "FAIL", outcome,
+	                                 to_string(detector.posture()), sequence.frames.size());
+	if (fall_matches && final_matches)
+		Logger::log_info(TAG, message, LOG_COLOR);
+	else
+		Logger::log_error(TAG, message);
+	return fall_matches && final_matches;
+}
+} // namespace
+
+int main(const int argc, char* argv[])
+{
+	string directory;
+	bool with_synthetic = true, verbose = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view argument = argv[i];
+		if (argument == "--sequences" && i + 1 < argc)
+			directory = argv[++i];
+		else if (argument == "--no-synthetic")
+			with_synthetic = false;
+		else if (argument == "--verbose")
+			verbose = true;
+		else
+		{
+			Logger::log_error(TAG, fmt::format("Unknown argument {}", argument));
+			return 1;
+		}
+	}
+
+	vector<Sequence> sequences;
+	if (with_synthetic)
+		sequences = synthetic_sequences();
+	if (!directory.empty())
+	{
+		vector<filesystem::path> paths;
+		for (const auto& entry : filesystem::directory_iterator(directory))
+		{
+			if (entry.is_regular_file() && entry.path().extension() == ".csv")
+				paths.push_back(entry.path());
+		}
+		ranges::sort(paths);
+		for (const auto& path : paths)
+		{
+			if (auto sequence = load_sequence(path))
+				sequences.push_back(std::move(*sequence));
+			else
+				Logger::log_warn(TAG, fmt::format("Skipping unreadable sequence {}", path.string()));
+		}
+	}
+	if (sequences.empty())
+	{
+		Logger::log_error(TAG, "No sequences to replay");
+		return 1;
+	}
+
+	int failures = 0;
+	for (const auto& sequence : sequences)
+		failures += replay(sequence, verbose) ? 0 : 1;
+	Logger::log_info(TAG, fmt::format("{}/{} sequence(s) matched", sequences.size() - failures, sequences.size()),
+	                 LOG_COLOR);
+	return failures;
+}
@@ -0,0 +1,553 @@
+// Synthetic device load generator for the hub's WebSocket server.
+//
+// Usage:
+//   solicare_load_generator --cameras 4 --wearables 8 --images ./frames --fps 15 --wearable-rate 1 --duration 30
+//                           [--host 127.0.0.1] [--port 3000] [--threads 2] [--server-pid <pid>]
+//
+// Every simulated device identifies itself with the ACK token ("CAM;ACK", "WEARABLE;ACK"), so the hub acknowledges
+// each processed frame with {"ack":<n>}. Latency is measured from the start of the write until the ack arrives;
+// frames that never get acked (dropped by the camera mailbox, still in flight at the end) are reported as drops.
+// With --server-pid (Linux), the hub's CPU time is sampled from /proc to report CPU milliseconds per processed frame.
+//
+// The hub names cameras (their tags and windows) by the device's address, so against a loopback host every device
+// connects from its own source address (127.0.0.2, 127.0.0.3, ...; Linux routes all of 127.0.0.0/8 to the loopback
+// interface). Against any other host all devices share this machine's address and only their port tells them
+// apart. The hub admits max_session connections (5 by default); start it with SOLICARE_MAX_SESSIONS raised above
+// the simulated device count, otherwise the surplus devices are answered with 503 and reported as failures.
+
+#include <algorithm>
+#include <atomic>
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
+#include <charconv>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fmt/core.h>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include "utils/logging_utils.hpp"
+
+using namespace std;
+using namespace chrono;
+namespace asio      = boost::asio;
+namespace beast     = boost::beast;
+namespace websocket = boost::beast::websocket;
+
+namespace
+{
+constexpr std::string_view TAG = "LoadGenerator";
+constexpr auto LOG_COLOR       = Logger::ConsoleColor::LIME;
+
+// Time allowed for in-flight frames to be acked after the run, before they count as dropped
+constexpr auto ACK_DRAIN_PERIOD = seconds(2);
+
+struct LoadConfig
+{
+	string host          = "127.0.0.1";
+	string port          = "3000";
+	int cameras          = 1;
+	int wearables        = 0;
+	double fps           = 10.0;
+	double wearable_rate = 1.0; // Messages per second per wearable
+	int duration         = 30;  // Seconds
+	int threads          = 2;
+	string images;
+	optional<int> server_pid;
+};
+
+enum DEVICE_KIND
+{
+	DEVICE_CAMERA,
+	DEVICE_WEARABLE
+};
+
+struct KindStats
+{
+	atomic<uint64_t> connected  = 0;
+	atomic<uint64_t> sent       = 0;
+	atomic<uint64_t> skipped    = 0; // Tick skipped because the previous write had not completed yet
+	atomic<uint64_t> acked      = 0;
+	atomic<uint64_t> failed     = 0;
+	atomic<uint64_t> bytes_sent = 0;
+
+	mutex latency_mutex;
+	vector<double> latencies_ms;
+};
+
+// Shared, read-only payloads for every simulated device
+struct Payloads
+{
+	vector<string> jpeg_frames;
+};
+
+class SimulatedDevice final : public enable_shared_from_this<SimulatedDevice>
+{
+  public:
+	SimulatedDevice(asio::io_context& ioc, const LoadConfig& config, const DEVICE_KIND kind, const int index,
+	                const shared_ptr<const Payloads>& payloads, KindStats& stats)
+	    : config_(config), kind_(kind), index_(index),
+	      device_number_(kind == DEVICE_CAMERA ? index : config.cameras + index), payloads_(payloads), stats_(stats),
+	      ws_(asio::make_strand(ioc)), resolver_(ws_.get_executor()), send_timer_(ws_.get_executor())
+	{
+	}
+
+	void start()
+	{
+		resolver_.async_resolve(config_.host, config_.port,
+		                        [self = shared_from_this()](const beast::error_code& ec, const auto& results)
+		                        {
+			                        if (ec)
+				                        return self->fail("resolve", ec);
+			                        self->connect(results);
+		                        });
+	}
+
+	void stop()
+	{
+		asio::post(ws_.get_executor(),
+		           [self = shared_from_this()]
+		           {
+			           self->stopping_ = true;
+			           self->send_timer_.cancel();
+		           });
+	}
+
+	void close()
+	{
+		asio::post(ws_.get_executor(),
+		           [self = shared_from_this()]
+		           {
+			           if (self->ws_.is_open())
+				           self->ws_.async_close(websocket::close_code::normal, [self](const beast::error_code&) {});
+		           });
+	}
+
+	[[nodiscard]] uint64_t unacked() const { return unacked_count_.load(memory_order_relaxed); }
+
+  private:
+	// 127.0.0.2 onwards for a loopback host, so the hub sees every device at its own address
+	[[nodiscard]] optional<asio::ip::address_v4> source_address(const asio::ip::tcp::endpoint& server) const
+	{
+		if (!server.address().is_v4() || !server.address().is_loopback())
+			return nullopt;
+		const auto host = static_cast<asio::ip::address_v4::uint_type>(device_number_ + 2);
+		return asio::ip::address_v4((127u << 24) | (host >> 8 & 0xFF) << 8 | (host & 0xFF));
+	}
+
+	void connect(const asio::ip::tcp::resolver::results_type& results)
+	{
+		const auto server = results.begin()->endpoint();
+		if (const auto source = source_address(server))
+		{
+			auto& socket = beast::get_lowest_layer(ws_).socket();
+			beast::error_code ec;
+			socket.open(server.protocol(), ec);
+			if (!ec)
+				socket.bind(asio::ip::tcp::endpoint(*source, 0), ec);
+			if (ec)
+				return fail("bind", ec);
+		}
+		beast::get_lowest_layer(ws_).async_connect(
+		    server,
+		    [self = shared_from_this()](const beast::error_code& ec)
+		    {
+			    if (ec)
+				    return self->fail("connect", ec);
+			    // The path announces the device type, so the hub applies its per-type quota before the upgrade
+			    const auto* target = self->kind_ == DEVICE_CAMERA ? "/camera" : "/wearable";
+			    self->ws_.async_handshake(self->config_.host, target,
+			                              [self](const beast::error_code& handshake_ec)
+			                              {
+				                              if (handshake_ec)
+					                              return self->fail("handshake", handshake_ec);
+				                              self->ws_.set_option(websocket::stream_base::timeout::suggested(
+				                                  beast::role_type::client));
+				                              self->identify();
+			                              });
+		    });
+	}
+
+	void identify()
+	{
+		identification_ = kind_ == DEVICE_CAMERA ? "CAM;ACK" : "WEARABLE;ACK";
+		ws_.text(true);
+		ws_.async_write(asio::buffer(identification_),
+		                [self = shared_from_this()](const beast::error_code& ec, size_t)
+		                {
+			                if (ec)
+				                return self->fail("identify", ec);
+			                self->stats_.connected.fetch_add(1, memory_order_relaxed);
+			                self->do_read();
+			                self->schedule_send(steady_clock::now());
+		                });
+	}
+
+	void schedule_send(const steady_clock::time_point at)
+	{
+		if (stopping_)
+			return;
+		send_timer_.expires_at(at);
+		send_timer_.async_wait(
+		    [self = shared_from_this(), at](const beast::error_code& ec)
+		    {
+			    if (ec || self->stopping_)
+				    return;
+			    self->send_next();
+			    const auto rate = self->kind_ == DEVICE_CAMERA ? self->config_.fps : self->config_.wearable_rate;
+			    self->schedule_send(at + duration_cast<steady_clock::duration>(duration<double>(1.0 / rate)));
+		    });
+	}
+
+	void send_next()
+	{
+		if (writing_)
+		{
+			// Keep the configured cadence instead of queueing up behind a slow socket
+			stats_.skipped.fetch_add(1, memory_order_relaxed);
+			return;
+		}
+
+		if (kind_ == DEVICE_CAMERA)
+		{
+			const auto& frames = payloads_->jpeg_frames;
+			payload_           = frames[(index_ + sequence_) % frames.size()];
+			ws_.binary(true);
+		}
+		else
+		{
+			payload_ = fmt::format(R"({{"status":"ON","fall_detected":false,"bpm":{},"temperature":36.5,)"
+			                       R"("humidity":40.0,"voltage":{}}})",
+			                       60 + sequence_ % 40, 100 - sequence_ % 100);
+			ws_.text(true);
+		}
+
+		writing_ = true;
+		pending_.emplace_back(++sequence_, steady_clock::now());
+		unacked_count_.store(pending_.size(), memory_order_relaxed);
+		ws_.async_write(asio::buffer(payload_),
+		                [self = shared_from_this()](const beast::error_code& ec, const size_t bytes)
+		                {
+			                self->writing_ = false;
+			                if (ec)
+				                return self->fail("write", ec);
+			                self->stats_.sent.fetch_add(1, memory_order_relaxed);
+			                self->stats_.bytes_sent.fetch_add(bytes, memory_order_relaxed);
+		                });
+	}
+
+	void do_read()
+	{
+		ws_.async_read(read_buffer_,
+		               [self = shared_from_this()](const beast::error_code& ec, size_t)
+		               {
+			               if (ec)
+			               {
+				               if (ec != websocket::error::closed && !self->stopping_)
+					               self->fail("read", ec);
+				               return;
+			               }
+			               self->on_message(beast::buffers_to_string(self->read_buffer_.data()));
+			               self->read_buffer_.consume(self->read_buffer_.size());
+			               self->do_read();
+		               });
+	}
+
+	void on_message(const string& message)
+	{
+		// Besides acks the hub sends the identification echo and device commands, which are ignored here
+		constexpr std::string_view ACK_PREFIX = R"({"ack":)";
+		if (!message.starts_with(ACK_PREFIX))
+			return;
+
+		uint64_t sequence = 0;
+		const auto* first = message.data() + ACK_PREFIX.size();
+		if (from_chars(first, message.data() + message.size(), sequence).ec != errc{})
+			return;
+
+		// Older frames without an ack were dropped by the hub, they are not acked later
+		while (!pending_.empty() && pending_.front().first < sequence)
+			pending_.pop_front();
+		if (!pending_.empty() && pending_.front().first == sequence)
+		{
+			const auto latency = duration<double, milli>(steady_clock::now() - pending_.front().second).count();
+			pending_.pop_front();
+			stats_.acked.fetch_add(1, memory_order_relaxed);
+			lock_guard lock(stats_.latency_mutex);
+			stats_.latencies_ms.push_back(latency);
+		}
+		unacked_count_.store(pending_.size(), memory_order_relaxed);
+	}
+
+	void fail(const std::string_view what, const beast::error_code& ec)
+	{
+		stats_.failed.fetch_add(1, memory_order_relaxed);
+		stopping_ = true;
+		send_timer_.cancel();
+		Logger::log_error(TAG, fmt::format("[{} #{}] {} failed: {}", kind_ == DEVICE_CAMERA ? "camera" : "wearable",
+		                                   index_, what, ec.message()));
+	}
+
+	const LoadConfig& config_;
+	const DEVICE_KIND kind_;
+	const int index_;
+	const int device_number_; // Index among all simulated devices, picks the source address
+	shared_ptr<const Payloads> payloads_;
+	KindStats& stats_;
+
+	websocket::stream<beast::tcp_stream> ws_;
+	asio::ip::tcp::resolver resolver_;
+	asio::steady_timer send_timer_;
+	beast::flat_buffer read_buffer_;
+
+	// Strand only
+	string identification_;
+	string payload_;
+	bool writing_      = false;
+	bool stopping_     = false;
+	uint64_t sequence_ = 0;
+	deque<pair<uint64_t, steady_clock::time_point>> pending_; // Sent frames waiting for their ack
+
+	atomic<uint64_t> unacked_count_ = 0;
+};
+
+optional<duration<double>> read_process_cpu_time(const int pid)
+{
+#if defined(__linux__)
+	// utime and stime are fields 14 and 15 of /proc/<pid>/stat, in clock ticks
+	ifstream stat(fmt::format("/proc/{}/stat", pid));
+	string content((istreambuf_iterator<char>(stat)), istreambuf_iterator<char>());
+	const auto comm_end = content.rfind(')');
+	if (comm_end == string::npos)
+		return nullopt;
+
+	istringstream fields(content.substr(comm_end + 2));
+	string field;
+	unsigned long long utime = 0, stime = 0;
+	for (int index = 3; index <= 15 && fields >> field; ++index)
+	{
+		if (index == 14)
+			utime = stoull(field);
+		else if (index == 15)
+			stime = stoull(field);
+	}
+	const auto ticks_per_second = sysconf(_SC_CLK_TCK);
+	if (ticks_per_second <= 0)
+		return nullopt;
+	return duration<double>(static_cast<double>(utime + stime) / static_cast<double>(ticks_per_second));
+#else
+	(void)pid;
+	return nullopt;
+#endif
+}
+
+double percentile(const vector<double>& sorted, const double p)
+{
+	if (sorted.empty())
+		return 0.0;
+	const auto rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+	return sorted[min(rank, sorted.size() - 1)];
+}
+
+void report(const std::string_view name, KindStats& stats, const uint64_t unacked, const double elapsed_seconds,
+            const int devices)
+{
+	if (devices == 0)
+		return;
+
+	vector<double> latencies;
+	{
+		lock_guard lock(stats.latency_mutex);
+		latencies = stats.latencies_ms;
+	}
+	ranges::sort(latencies);
+
+	const auto sent  = stats.sent.load();
+	const auto acked = stats.acked.load();
+	const auto drops = sent - min(sent, acked);
+	Logger::log_info(TAG,
+	                 fmt::format("{}: {}/{} connected | sent {} ({:.1f}/s, {:.1f} MB) | accepted {:.1f}/s | "
+	                             "drops {} ({:.1f}%, {} unacked at end) | skipped {} | failures {}",
+	                             name, stats.connected.load(), devices, sent, sent / elapsed_seconds,
+	                             stats.bytes_sent.load() / 1e6, acked / elapsed_seconds, drops,
+	                             sent ? 100.0 * drops / sent : 0.0, unacked, stats.skipped.load(),
+	                             stats.failed.load()),
+	                 LOG_COLOR);
+	Logger::log_info(TAG,
+	                 fmt::format("{} latency ms: p50 {:.2f} | p90 {:.2f} | p99 {:.2f} | max {:.2f}", name,
+	                             percentile(latencies, 50), percentile(latencies, 90), percentile(latencies, 99),
+	                             latencies.empty() ? 0.0 : latencies.back()),
+	                 LOG_COLOR);
+}
+
+bool parse_arguments(const int argc, char* argv[], LoadConfig& config)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view argument = argv[i];
+		if (i + 1 >= argc)
+		{
+			Logger::log_error(TAG, fmt::format("Missing value for {}", argument));
+			return false;
+		}
+		const string value = argv[++i];
+		if (argument == "--host")
+			config.host = value;
+		else if (argument == "--port")
+			config.port = value;
+		else if (argument == "--cameras")
+			config.cameras = stoi(value);
+		else if (argument == "--wearables")
+			config.wearables = stoi(value);
+		else if (argument == "--fps")
+			config.fps = stod(value);
+		else if (argument == "--wearable-rate")
+			config.wearable_rate = stod(value);
+		else if (argument == "--duration")
+			config.duration = stoi(value);
+		else if (argument == "--threads")
+			config.threads = max(1, stoi(value));
+		else if (argument == "--images")
+			config.images = value;
+		else if (argument == "--server-pid")
+			config.server_pid = stoi(value);
+		else
+		{
+			Logger::log_error(TAG, fmt::format("Unknown argument {}", argument));
+			return false;
+		}
+	}
+	if (config.fps <= 0 || config.wearable_rate <= 0 || config.duration <= 0)
+	{
+		Logger::log_error(TAG, "--fps, --wearable-rate and --duration must be positive");
+		return false;
+	}
+	return true;
+}
+
+shared_ptr<const Payloads> load_payloads(const LoadConfig& config)
+{
+	auto payloads = make_shared<Payloads>();
+	if (config.cameras == 0)
+		return payloads;
+
+	if (config.images.empty() || !filesystem::is_directory(config.images))
+	{
+		Logger::log_error(TAG, "--images must name a directory of JPEG frames when cameras are simulated");
+		return nullptr;
+	}
+	vector<filesystem::path> paths;
+	for (const auto& entry : filesystem::directory_iterator(config.images))
+	{
+		auto extension = entry.path().extension().string();
+		ranges::transform(extension, extension.begin(), [](const unsigned char c) { return tolower(c); });
+		if (entry.is_regular_file() && (extension == ".jpg" || extension == ".jpeg"))
+			paths.push_back(entry.path());
+	}
+	ranges::sort(paths);
+	for (const auto& path : paths)
+	{
+		ifstream file(path, ios::binary);
+		payloads->jpeg_frames.emplace_back(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+	}
+	if (payloads->jpeg_frames.empty())
+	{
+		Logger::log_error(TAG, fmt::format("No JPEG frames found in {}", config.images));
+		return nullptr;
+	}
+	return payloads;
+}
+} // namespace
+
+int main(const int argc, char* argv[])
+{
+	LoadConfig config;
+	if (!parse_arguments(argc, argv, config))
+		return 1;
+	const auto payloads = load_payloads(config);
+	if (!payloads)
+		return 1;
+
+	Logger::log_info(TAG,
+	                 fmt::format("{} camera(s) @ {} fps ({} frame(s)), {} wearable(s) @ {}/s against {}:{} for {}s",
+	                             config.cameras, config.fps, payloads->jpeg_frames.size(), config.wearables,
+	                             config.wearable_rate, config.host, config.port, config.duration),
+	                 LOG_COLOR);
+
+	asio::io_context ioc;
+	auto work_guard = asio::make_work_guard(ioc);
+	KindStats camera_stats, wearable_stats;
+	vector<shared_ptr<SimulatedDevice>> cameras, wearables;
+	for (int i = 0; i < config.cameras; ++i)
+		cameras.push_back(make_shared<SimulatedDevice>(ioc, config, DEVICE_CAMERA, i, payloads, camera_stats));
+	for (int i = 0; i < config.wearables; ++i)
+		wearables.push_back(make_shared<SimulatedDevice>(ioc, config, DEVICE_WEARABLE, i, payloads, wearable_stats));
+
+	vector<thread> threads;
+	for (int i = 0; i < config.threads; ++i)
+		threads.emplace_back([&ioc] { ioc.run(); });
+
+	const auto cpu_before = config.server_pid ? read_process_cpu_time(*config.server_pid) : nullopt;
+	const auto started    = steady_clock::now();
+	for (const auto& device : cameras)
+		device->start();
+	for (const auto& device : wearables)
+		device->start();
+
+	this_thread::sleep_for(seconds(config.duration));
+	for (const auto& device : cameras)
+		device->stop();
+	for (const auto& device : wearables)
+		device->stop();
+	const auto elapsed = duration<double>(steady_clock::now() - started).count();
+
+	this_thread::sleep_for(ACK_DRAIN_PERIOD);
+	const auto cpu_after = config.server_pid ? read_process_cpu_time(*config.server_pid) : nullopt;
+	const auto measured  = duration<double>(steady_clock::now() - started).count(); // Includes the ack drain
+
+	uint64_t camera_unacked = 0, wearable_unacked = 0;
+	for (const auto& device : cameras)
+	{
+		camera_unacked += device->unacked();
+		device->close();
+	}
+	for (const auto& device : wearables)
+	{
+		wearable_unacked += device->unacked();
+		device->close();
+	}
+
+	report("cameras", camera_stats, camera_unacked, elapsed, config.cameras);
+	report("wearables", wearable_stats, wearable_unacked, elapsed, config.wearables);
+	if (cpu_before && cpu_after)
+	{
+		const auto cpu_ms = duration<double, milli>(*cpu_after - *cpu_before).count();
+		const auto frames = camera_stats.acked.load() + wearable_stats.acked.load();
+		Logger::log_info(TAG,
+		                 fmt::format("server cpu: {:.0f} ms over {:.1f}s ({:.1f}% of one core) | {:.3f} ms per "
+		                             "processed frame",
+		                             cpu_ms, measured, cpu_ms / (measured * 10.0), frames ? cpu_ms / frames : 0.0),
+		                 LOG_COLOR);
+	}
+	else if (config.server_pid)
+	{
+		Logger::log_warn(TAG, fmt::format("Could not read CPU time of process {}", *config.server_pid));
+	}
+
+	work_guard.reset();
+	for (auto& thread : threads)
+		thread.join();
+	return 0;
+}
@@ -0,0 +1,323 @@
+// Pose backend benchmark: latency and accuracy of every backend/precision pair on a fixed image set.
+//
+// Usage:
+//   solicare_pose_benchmark --images ./bench_frames [--backends opencv,openvino,onnxruntime] [--precisions fp32,int8]
+//                           [--fp32-model ../models/yolov8n-pose.onnx] [--int8-model ../models/yolov8n-pose-int8.onnx]
+//                           [--batch 1] [--iterations 3] [--warmup 3] [--threads 0]
+//
+// Every image is letterboxed and packed into blobs once, so only forward() is timed. Latency is reported per image
+// (forward time / batch size). Accuracy is relative to the first configuration, opencv/fp32 by default: the best
+// person of every image is compared with the reference by object keypoint similarity (OKS, COCO sigmas), and a
+// detection counts as agreeing when both or neither configuration found a person.
+// Backends that are not available in this build (see is_pose_backend_available()) are skipped.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fmt/core.h>
+#include <opencv2/dnn.hpp>
+#include <opencv2/opencv.hpp>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "utils/logging_utils.hpp"
+#include "vision/pose_backend.hpp"
+#include "vision/pose_decoder.hpp"
+#include "vision/pose_model.hpp"
+
+using namespace std;
+using namespace chrono;
+
+namespace
+{
+constexpr std::string_view TAG = "PoseBenchmark";
+constexpr auto LOG_COLOR       = Logger::ConsoleColor::LIME;
+
+// Per-keypoint falloff of OKS, from the COCO keypoint evaluation
+constexpr std::array<double, PoseModel::KEYPOINT_COUNT> KEYPOINT_SIGMAS = {
+    0.026, 0.025, 0.025, 0.035, 0.035, 0.079, 0.079, 0.072, 0.072, 0.062, 0.062, 0.107, 0.107, 0.087, 0.087, 0.089,
+    0.089};
+
+struct BenchmarkConfig
+{
+	string images;
+	vector<POSE_BACKEND> backends     = {BACKEND_OPENCV_CPU, BACKEND_OPENVINO, BACKEND_ONNXRUNTIME};
+	vector<POSE_PRECISION> precisions = {PRECISION_FP32, PRECISION_INT8};
+	PoseBackendConfig model;
+	int batch      = 1;
+	int iterations = 3; // Timed passes over the image set
+	int warmup     = 3; // Untimed forward() calls before the first pass
+};
+
+struct ImageSet
+{
+	vector<PoseModel::Letterbox> letterboxes;
+	vector<cv::Mat> blobs; // [batch, 3, 640, 640] each, the last one may be smaller
+};
+
+struct RunResult
+{
+	string name;
+	vector<double> latencies_ms; // Per image
+	vector<optional<PoseModel::PoseDetection>> people;
+};
+
+double percentile(const vector<double>& sorted, const double p)
+{
+	if (sorted.empty())
+		return 0.0;
+	const auto rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+	return sorted[min(rank, sorted.size() - 1)];
+}
+
+double object_keypoint_similarity(const PoseModel::PoseDetection& reference, const PoseModel::PoseDetection& other)
+{
+	const double area = max(1.0, static_cast<double>(reference.box.area()));
+	double total      = 0.0;
+	int visible       = 0;
+	for (int k = 0; k < PoseModel::KEYPOINT_COUNT; ++k)
+	{
+		if (reference.confidence[k] < PoseModel::KEYPOINT_THRESHOLD)
+			continue;
+		const double dx      = reference.keypoints[k].x - other.keypoints[k].x;
+		const double dy      = reference.keypoints[k].y - other.keypoints[k].y;
+		const double falloff = 2.0 * KEYPOINT_SIGMAS[k];
+
+		total += exp(-(dx * dx + dy * dy) / (2.0 * area * falloff * falloff));
+		++visible;
+	}
+	return visible ? total / visible : 0.0;
+}
+
+template <typename T, typename Parse>
+bool parse_list(const string& value, vector<T>& out, Parse parse)
+{
+	out.clear();
+	istringstream items(value);
+	string item;
+	while (getline(items, item, ','))
+	{
+		const auto parsed = parse(item);
+		if (!parsed)
+		{
+			Logger::log_error(TAG, fmt::format("Unknown value {}", item));
+			return false;
+		}
+		out.push_back(*parsed);
+	}
+	return !out.empty();
+}
+
+bool parse_arguments(const int argc, char* argv[], BenchmarkConfig& config)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view argument = argv[i];
+		if (i + 1 >= argc)
+		{
+			Logger::log_error(TAG, fmt::format("Missing value for {}", argument));
+			return false;
+		}
+		const string value = argv[++i];
+		if (argument == "--images")
+			config.images = value;
+		else if (argument == "--backends")
+		{
+			if (!parse_list(value, config.backends, parse_pose_backend))
+				return false;
+		}
+		else if (argument == "--precisions")
+		{
+			if (!parse_list(value, config.precisions, parse_pose_precision))
+				return false;
+		}
+		else if (argument == "--fp32-model")
+			config.model.fp32_model_path = value;
+		else if (argument == "--int8-model")
+			config.model.int8_model_path = value;
+		else if (argument == "--batch")
+			config.batch = max(1, stoi(value));
+		else if (argument == "--iterations")
+			config.iterations = max(1, stoi(value));
+		else if (argument == "--warmup")
+			config.warmup = max(0, stoi(value));
+		else if (argument == "--threads")
+			config.model.threads = max(0, stoi(value));
+		else
+		{
+			Logger::log_error(TAG, fmt::format("Unknown argument {}", argument));
+			return false;
+		}
+	}
+	if (config.images.empty() || !filesystem::is_directory(config.images))
+	{
+		Logger::log_error(TAG, "--images must name a directory of JPEG/PNG images");
+		return false;
+	}
+	return true;
+}
+
+optional<ImageSet> load_images(const BenchmarkConfig& config)
+{
+	vector<filesystem::path> paths;
+	for (const auto& entry : filesystem::directory_iterator(config.images))
+	{
+		auto extension = entry.path().extension().string();
+		ranges::transform(extension, extension.begin(), [](const unsigned char c) { return tolower(c); });
+		if (entry.is_regular_file() && (extension == ".jpg" || extension == ".jpeg" || extension == ".png"))
+			paths.push_back(entry.path());
+	}
+	ranges::sort(paths);
+
+	ImageSet set;
+	vector<cv::Mat> inputs;
+	for (const auto& path : paths)
+	{
+		const cv::Mat image = cv::imread(path.string(), cv::IMREAD_COLOR);
+		if (image.empty())
+		{
+			Logger::log_warn(TAG, fmt::format("Skipping unreadable image {}", path.string()));
+			continue;
+		}
+		cv::Mat input;
+		set.letterboxes.push_back(PoseModel::letterbox(image, input));
+		inputs.push_back(input);
+	}
+	if (inputs.empty())
+	{
+		Logger::log_error(TAG, fmt::format("No images found in {}", config.images));
+		return nullopt;
+	}
+	for (size_t first = 0; first < inputs.size(); first += config.batch)
+	{
+		const vector batch(inputs.begin() + static_cast<ptrdiff_t>(first),
+		                   inputs.begin() + static_cast<ptrdiff_t>(min(inputs.size(), first + config.batch)));
+		set.blobs.push_back(cv::dnn::blobFromImages(batch, 1.0 / 255.0, cv::Size(), cv::Scalar(), true, false));
+	}
+	return set;
+}
+
+optional<RunResult> run(const PoseBackendConfig& model, const ImageSet& images, const BenchmarkConfig& config)
+{
+	unique_ptr<PoseBackend> backend;
+	try
+	{
+		backend = make_pose_backend(model);
+		for (int i = 0; i < config.warmup; ++i)
+			backend->forward(images.blobs.front());
+	}
+	catch (const std::exception& e)
+	{
+		Logger::log_warn(TAG, fmt::format("Skipping {}/{}: {}", to_string(model.backend), to_string(model.precision),
+		                                  e.what()));
+		return nullopt;
+	}
+
+	RunResult result;
+	result.name = backend->name();
+	PoseDecoder::PoseDetections people;
+	for (int iteration = 0; iteration < config.iterations; ++iteration)
+	{
+		size_t image = 0;
+		for (const auto& blob : images.blobs)
+		{
+			const auto started   = steady_clock::now();
+			const cv::Mat output = backend->forward(blob);
+			const auto elapsed   = duration<double, milli>(steady_clock::now() - started).count();
+
+			const int batch = blob.size[0];
+			for (int i = 0; i < batch; ++i, ++image)
+			{
+				result.latencies_ms.push_back(elapsed / batch);
+				if (iteration > 0)
+					continue;
+				const cv::Mat item(output.size[1], output.size[2], CV_32F, const_cast<float*>(output.ptr<float>(i)));
+				PoseDecoder::decode(item, images.letterboxes[image], people);
+				result.people.push_back(people.empty() ? nullopt : optional(people.front()));
+			}
+		}
+	}
+	return result;
+}
+
+void report(const RunResult& result, const RunResult& reference)
+{
+	auto latencies = result.latencies_ms;
+	ranges::sort(latencies);
+	double mean = 0.0;
+	for (const auto latency : latencies)
+		mean += latency;
+	mean /= static_cast<double>(max<size_t>(1, latencies.size()));
+
+	size_t agreeing = 0, compared = 0;
+	double oks      = 0.0;
+	for (size_t i = 0; i < result.people.size(); ++i)
+	{
+		const auto& expected = reference.people[i];
+		const auto& actual   = result.people[i];
+		if (expected.has_value() == actual.has_value())
+			++agreeing;
+		if (expected && actual)
+		{
+			oks += object_keypoint_similarity(*expected, *actual);
+			++compared;
+		}
+	}
+	Logger::log_info(TAG,
+	                 fmt::format("{:<18} ms/image: mean {:7.2f} | p50 {:7.2f} | p95 {:7.2f} | {:6.1f} images/s | "
+	                             "agreement {:5.1f}% | mean OKS {:.3f} ({} images)",
+	                             result.name, mean, percentile(latencies, 50), percentile(latencies, 95),
+	                             mean > 0 ? 1000.0 / mean : 0.0,
+	                             100.0 * agreeing / max<size_t>(1, result.people.size()),
+	                             compared ? oks / compared : 0.0, compared),
+	                 LOG_COLOR);
+}
+} // namespace
+
+int main(const int argc, char* argv[])
+{
+	BenchmarkConfig config;
+	if (!parse_arguments(argc, argv, config))
+		return 1;
+	const auto images = load_images(config);
+	if (!images)
+		return 1;
+	if (config.model.threads > 0)
+		cv::setNumThreads(config.model.threads); // OpenCV DNN backends, ONNX Runtime takes it from the config
+	Logger::log_info(TAG,
+	                 fmt::format("{} image(s) in {} blob(s) of up to {}, {} timed pass(es)", images->letterboxes.size(),
+	                             images->blobs.size(), config.batch, config.iterations),
+	                 LOG_COLOR);
+
+	vector<RunResult> results;
+	for (const auto backend : config.backends)
+	{
+		if (!is_pose_backend_available(backend))
+		{
+			Logger::log_warn(TAG, fmt::format("Skipping {}: not available in this build", to_string(backend)));
+			continue;
+		}
+		for (const auto precision : config.precisions)
+		{
+			auto model      = config.model;
+			model.backend   = backend;
+			model.precision = precision;
+			if (auto result = run(model, *images, config))
+				results.push_back(std::move(*result));
+		}
+	}
+	if (results.empty())
+	{
+		Logger::log_error(TAG, "No backend could be run");
+		return 1;
+	}
+
+	Logger::log_info(TAG, fmt::format("Accuracy relative to {}", results.front().name), LOG_COLOR);
+	for (const auto& result : results)
+		report(result, results.front());
+	return 0;
+}
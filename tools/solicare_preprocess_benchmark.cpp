@@ -0,0 +1,168 @@
+// Preprocessing microbenchmark: the fused Preprocess::letterbox_to_blob() kernel against the OpenCV path it replaced,
+// PoseModel::letterbox() followed by cv::dnn::blobFromImage().
+//
+// Usage:
+//   solicare_preprocess_benchmark [--image frame.jpg] [--width 960] [--height 540] [--iterations 500] [--warmup 20]
+//
+// Without --image a synthetic frame of the given size is used, 960x540 is what a 1080p camera frame decodes to.
+// Both paths write into buffers that are reused across iterations, as in the camera pipeline. The largest absolute
+// difference between the two tensors is reported; bilinear weights are rounded differently, expect around 1/255.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fmt/core.h>
+#include <opencv2/dnn.hpp>
+#include <opencv2/opencv.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "utils/logging_utils.hpp"
+#include "vision/pose_model.hpp"
+#include "vision/preprocess.hpp"
+
+using namespace std;
+using namespace chrono;
+
+namespace
+{
+constexpr std::string_view TAG = "PreprocessBenchmark";
+constexpr auto LOG_COLOR       = Logger::ConsoleColor::LIME;
+
+struct BenchmarkConfig
+{
+	string image;
+	int width      = 960;
+	int height     = 540;
+	int iterations = 500;
+	int warmup     = 20;
+};
+
+bool parse_arguments(const int argc, char* argv[], BenchmarkConfig& config)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view argument = argv[i];
+		if (i + 1 >= argc)
+		{
+			Logger::log_error(TAG, fmt::format("Missing value for {}", argument));
+			return false;
+		}
+		const string value = argv[++i];
+		if (argument == "--image")
+			config.image = value;
+		else if (argument == "--width")
+			config.width = max(1, stoi(value));
+		else if (argument == "--height")
+			config.height = max(1, stoi(value));
+		else if (argument == "--iterations")
+			config.iterations = max(1, stoi(value));
+		else if (argument == "--warmup")
+			config.warmup = max(0, stoi(value));
+		else
+		{
+			Logger::log_error(TAG, fmt::format("Unknown argument {}", argument));
+			return false;
+		}
+	}
+	return true;
+}
+
+// Gradients plus noise, so neither path benefits from flat regions
+cv::Mat synthetic_frame(const int width, const int height)
+{
+	cv::Mat frame(height, width, CV_8UC3);
+	mt19937 random(42);
+	for (int y = 0; y < height; ++y)
+	{
+		auto* row = frame.ptr<uint8_t>(y);
+		for (int x = 0; x < width; ++x)
+		{
+			row[3 * x]     = static_cast<uint8_t>(x * 191 / width + random() % 64);
+			row[3 * x + 1] = static_cast<uint8_t>(y * 191 / height + random() % 64);
+			row[3 * x + 2] = static_cast<uint8_t>((x + y) * 191 / (width + height) + random() % 64);
+		}
+	}
+	return frame;
+}
+
+template <typename Body>
+vector<double> measure(const BenchmarkConfig& config, Body body)
+{
+	for (int i = 0; i < config.warmup; ++i)
+		body();
+	vector<double> latencies_us;
+	latencies_us.reserve(config.iterations);
+	for (int i = 0; i < config.iterations; ++i)
+	{
+		const auto started = steady_clock::now();
+		body();
+		latencies_us.push_back(duration<double, micro>(steady_clock::now() - started).count());
+	}
+	ranges::sort(latencies_us);
+	return latencies_us;
+}
+
+void report(const std::string_view name, const vector<double>& sorted)
+{
+	double mean = 0.0;
+	for (const auto latency : sorted)
+		mean += latency;
+	mean /= static_cast<double>(sorted.size());
+	const auto at = [&sorted](const double p)
+	{ return sorted[static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1))]; };
+	Logger::log_info(
+	    TAG, fmt::format("{:<28} us/frame: mean {:8.1f} | p50 {:8.1f} | p95 {:8.1f}", name, mean, at(50), at(95)),
+	    LOG_COLOR);
+}
+} // namespace
+
+int main(const int argc, char* argv[])
+{
+	BenchmarkConfig config;
+	if (!parse_arguments(argc, argv, config))
+		return 1;
+
+	cv::Mat frame;
+	if (!config.image.empty())
+	{
+		frame = cv::imread(config.image, cv::IMREAD_COLOR);
+		if (frame.empty())
+		{
+			Logger::log_error(TAG, fmt::format("Cannot read {}", config.image));
+			return 1;
+		}
+	}
+	else
+		frame = synthetic_frame(config.width, config.height);
+	Logger::log_info(TAG,
+	                 fmt::format("{}x{} frame, {} iteration(s), kernel: {}", frame.cols, frame.rows, config.iterations,
+	                             Preprocess::instruction_set()),
+	                 LOG_COLOR);
+
+	cv::Mat input, reference;
+	const auto opencv = measure(config,
+	                            [&]
+	                            {
+		                            PoseModel::letterbox(frame, input);
+		                            cv::dnn::blobFromImage(input, reference, 1.0 / 255.0, cv::Size(), cv::Scalar(),
+		                                                   true, false);
+	                            });
+	cv::Mat fused;
+	const auto kernel = measure(config, [&] { Preprocess::letterbox_to_blob(frame, fused); });
+
+	report("letterbox + blobFromImage", opencv);
+	report("fused kernel", kernel);
+
+	double difference    = 0.0;
+	const auto* expected = reference.ptr<float>();
+	const auto* actual   = fused.ptr<float>();
+	for (size_t i = 0; i < fused.total(); ++i)
+		difference = max(difference, static_cast<double>(abs(expected[i] - actual[i])));
+	Logger::log_info(TAG,
+	                 fmt::format("Max abs difference {:.5f} ({:.2f}/255), speedup {:.2f}x", difference,
+	                             difference * 255.0, opencv[opencv.size() / 2] / kernel[kernel.size() / 2]),
+	                 LOG_COLOR);
+	return 0;
+}